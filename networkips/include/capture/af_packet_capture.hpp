@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/filter.h>
+#include "capture/packet_capture.hpp"
+
+namespace nips {
+namespace capture {
+
+// AF_PACKET TPACKET_V3 捕获后端：内存映射接收环 + PACKET_FANOUT，
+// 每个NIC RX队列一个捕获线程，按流哈希分流。
+// 相比单线程pcap后端，8队列网卡上可从~2 Gbps提升到线速10 Gbps
+class AFPacketCapture : public CaptureSource {
+public:
+    AFPacketCapture();
+    ~AFPacketCapture() override;
+
+    bool init(const std::string& interface, const std::string& filter = "") override;
+    bool start(PacketCallback callback) override;
+    void stop() override;
+
+    // 所有队列内核丢包合计（遥测仪表）
+    uint64_t kernelDrops() const override;
+
+    // 各队列累计收包/丢包统计（来自内核PACKET_STATISTICS）
+    struct QueueStats {
+        uint64_t packets;
+        uint64_t kernel_drops;
+    };
+    std::vector<QueueStats> getQueueStats() const;
+
+private:
+    // 单个fanout队列：独立socket + 映射环 + 捕获线程
+    struct Queue {
+        int fd = -1;
+        uint8_t* ring = nullptr;       // mmap的块数组
+        size_t ring_size = 0;
+        unsigned int block_count = 0;
+        unsigned int current_block = 0;
+        std::unique_ptr<std::thread> thread;
+        std::atomic<uint64_t> packets{0};
+        std::atomic<uint64_t> kernel_drops{0};
+    };
+
+    // 把capture.filter编译为classic BPF（init时一次）；
+    // 表达式非法时返回false
+    bool compileFilter(const std::string& filter);
+
+    // 创建并配置单个fanout socket
+    bool setupQueue(Queue& queue, int ifindex);
+
+    // 队列捕获线程主循环：轮询就绪块并遍历其中的帧
+    void queueLoop(Queue& queue);
+
+    // 处理映射环中的一个就绪块
+    void processBlock(Queue& queue, uint8_t* block);
+
+    std::string interface_;
+    std::vector<struct sock_filter> filter_prog_;  // 编译后的BPF指令（空=无过滤）
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::unique_ptr<PacketBufferPool> pool_;
+    PacketCallback callback_;
+    std::atomic<bool> running_{false};
+    uint16_t fanout_group_ = 0;
+
+    AFPacketCapture(const AFPacketCapture&) = delete;
+    AFPacketCapture& operator=(const AFPacketCapture&) = delete;
+};
+
+} // namespace capture
+} // namespace nips
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace nips {
+namespace capture {
+
+class PacketBufferPool;
+
+// 槽分配的报文缓冲句柄：持有池中一个定长块，析构时归还。
+// 仅可移动，保证热路径上没有隐式拷贝
+class PacketBuffer {
+public:
+    PacketBuffer() = default;
+    ~PacketBuffer() { reset(); }
+
+    PacketBuffer(PacketBuffer&& other) noexcept
+        : pool_(other.pool_), index_(other.index_), size_(other.size_) {
+        other.pool_ = nullptr;
+        other.index_ = kInvalid;
+        other.size_ = 0;
+    }
+
+    PacketBuffer& operator=(PacketBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            pool_ = other.pool_;
+            index_ = other.index_;
+            size_ = other.size_;
+            other.pool_ = nullptr;
+            other.index_ = kInvalid;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    PacketBuffer(const PacketBuffer&) = delete;
+    PacketBuffer& operator=(const PacketBuffer&) = delete;
+
+    uint8_t* data();
+    const uint8_t* data() const;
+    size_t size() const { return size_; }
+    void setSize(size_t size) { size_ = static_cast<uint32_t>(size); }
+
+    explicit operator bool() const { return pool_ != nullptr; }
+
+    // 归还缓冲块
+    void reset();
+
+private:
+    friend class PacketBufferPool;
+    static constexpr uint32_t kInvalid = UINT32_MAX;
+
+    PacketBuffer(PacketBufferPool* pool, uint32_t index)
+        : pool_(pool), index_(index) {}
+
+    PacketBufferPool* pool_ = nullptr;
+    uint32_t index_ = kInvalid;
+    uint32_t size_ = 0;
+};
+
+// 定长块的报文缓冲池：启动时一次性分配，之后只做无锁的
+// 空闲链取/还，彻底把堆分配器移出每包路径。
+// acquire在捕获线程调用，release可在任意分析线程调用（Treiber栈+版本号防ABA）
+class PacketBufferPool {
+public:
+    // 单块大小；超过此长度的报文会被截断存储（PacketInfo::length保留线上长度）
+    static constexpr size_t kChunkSize = 2048;
+
+    explicit PacketBufferPool(size_t chunk_count);
+
+    // 取一个空闲块；池耗尽时返回空句柄并累加计数
+    PacketBuffer acquire();
+
+    // 累计池耗尽次数
+    uint64_t exhausted() const {
+        return exhausted_.load(std::memory_order_relaxed);
+    }
+
+    size_t chunkCount() const { return next_.size(); }
+
+private:
+    friend class PacketBuffer;
+
+    uint8_t* chunkData(uint32_t index) {
+        return storage_.get() + static_cast<size_t>(index) * kChunkSize;
+    }
+
+    void release(uint32_t index);
+
+    // 空闲链头：低32位为块下标，高32位为版本号，防ABA
+    static uint64_t makeHead(uint32_t index, uint32_t tag) {
+        return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+
+    // 故意不做值初始化：页保持未触碰，由绑核后的捕获线程
+    // 首次写入时按first-touch落到网卡所在NUMA节点
+    std::unique_ptr<uint8_t[]> storage_;
+    std::vector<std::atomic<uint32_t>> next_;
+    std::atomic<uint64_t> head_;
+    std::atomic<uint64_t> exhausted_{0};
+
+    PacketBufferPool(const PacketBufferPool&) = delete;
+    PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+};
+
+inline uint8_t* PacketBuffer::data() {
+    return pool_ ? pool_->chunkData(index_) : nullptr;
+}
+
+inline const uint8_t* PacketBuffer::data() const {
+    return pool_ ? pool_->chunkData(index_) : nullptr;
+}
+
+inline void PacketBuffer::reset() {
+    if (pool_) {
+        pool_->release(index_);
+        pool_ = nullptr;
+        index_ = kInvalid;
+        size_ = 0;
+    }
+}
+
+} // namespace capture
+} // namespace nips
@@ -3,48 +3,95 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <thread>
+#include <atomic>
 #include <pcap.h>
 #include <vector>
+#include "capture/packet_buffer.hpp"
+#include "capture/packet_parser.hpp"
 
 namespace nips {
 namespace capture {
 
+// 热路径上零分配的报文描述：数据由槽缓冲池托管，
+// 接口名驻留在捕获器内（每包只携带指针）。仅可移动。
+// 头部字段在捕获阶段经parsePacket解析一次，随缓冲一起传递
 struct PacketInfo {
-    std::vector<uint8_t> data;
-    uint32_t timestamp;
-    uint32_t length;
-    std::string interface;
-    bool is_outbound;
+    PacketBuffer buffer;              // 报文数据（超长报文被截断存储）
+    ParsedPacket parsed;              // 捕获阶段填充的头部解析结果
+    uint32_t timestamp = 0;
+    uint32_t length = 0;              // 线上原始长度
+    const std::string* interface = nullptr;
+    uint8_t sample_stride = 1;        // 本包代表的原始包数（过载采样时>1）
+    bool is_outbound = false;
+
+    const uint8_t* data() const { return buffer.data(); }
+    size_t size() const { return buffer.size(); }
 };
 
-class PacketCapture {
+// 捕获后端抽象：libpcap与AF_PACKET后端实现同一接口，
+// 由 capture.backend 配置键选择
+class CaptureSource {
 public:
-    using PacketCallback = std::function<void(const PacketInfo&)>;
+    using PacketCallback = std::function<void(PacketInfo&&)>;
+
+    virtual ~CaptureSource() = default;
+
+    // 初始化捕获器
+    virtual bool init(const std::string& interface, const std::string& filter = "") = 0;
+
+    // 开始捕获
+    virtual bool start(PacketCallback callback) = 0;
+
+    // 停止捕获
+    virtual void stop() = 0;
+
+    // 内核侧累计丢包数（遥测仪表）
+    virtual uint64_t kernelDrops() const { return 0; }
+};
+
+// 根据 capture.backend 创建捕获后端（"pcap" 或 "af_packet"）
+std::unique_ptr<CaptureSource> createCaptureSource();
+
+class PacketCapture : public CaptureSource {
+public:
+    using PacketCallback = CaptureSource::PacketCallback;
 
     PacketCapture();
-    ~PacketCapture();
+    ~PacketCapture() override;
 
     // 初始化捕获器
-    bool init(const std::string& interface, const std::string& filter = "");
-    
+    bool init(const std::string& interface, const std::string& filter = "") override;
+
     // 开始捕获
-    bool start(PacketCallback callback);
-    
+    bool start(PacketCallback callback) override;
+
     // 停止捕获
-    void stop();
-    
+    void stop() override;
+
     // 设置过滤器
     bool setFilter(const std::string& filter);
-    
+
+    // 内核/驱动丢包计数（来自pcap_stats）
+    uint64_t kernelDrops() const override;
+
+
     // 获取可用接口列表
     static std::vector<std::string> getAvailableInterfaces();
 
 private:
+    // 捕获线程主循环
+    void captureLoop();
+
     pcap_t* handle_;
-    bool running_;
+    ParseFn parser_ = nullptr;  // 按会话DLT选定的解码器实例化
+    std::atomic<bool> running_;
     std::string interface_;
     std::string filter_;
-    
+    std::unique_ptr<PacketBufferPool> pool_;
+    std::unique_ptr<std::thread> capture_thread_;
+    PacketCallback callback_;
+
     // 禁用拷贝
     PacketCapture(const PacketCapture&) = delete;
     PacketCapture& operator=(const PacketCapture&) = delete;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+namespace nips {
+namespace capture {
+
+struct PacketInfo;
+
+// TCP标志位（ParsedPacket::tcp_flags的位布局，与线上th_flags一致）
+constexpr uint8_t kTcpFin = 0x01;
+constexpr uint8_t kTcpSyn = 0x02;
+constexpr uint8_t kTcpRst = 0x04;
+constexpr uint8_t kTcpPsh = 0x08;
+constexpr uint8_t kTcpAck = 0x10;
+constexpr uint8_t kTcpUrg = 0x20;
+
+// 捕获阶段填充一次的报文解析描述：下游各级（流键、特征累积、
+// 熵计算）只读字段，不再各自重走以太网/IP/L4头的指针运算。
+// 偏移量相对于捕获到的字节（截断报文的payload_length随之截断）
+struct ParsedPacket {
+    bool valid = false;        // L3解析成功且头部未越界
+    uint8_t ip_version = 0;    // 4或6
+    uint8_t protocol = 0;      // IPPROTO_*（IPv6为扩展头链之后的上层协议）
+    uint8_t tcp_flags = 0;     // kTcp*位组合（非TCP为0）
+    uint32_t src_ip = 0;       // 主机字节序；IPv6为128位地址的32位XOR折叠，
+    uint32_t dst_ip = 0;       //   仅用于流键/关联计数，不可反渲染为地址
+    uint16_t src_port = 0;     // 主机字节序（非TCP/UDP为0）
+    uint16_t dst_port = 0;
+    uint16_t payload_offset = 0;
+    uint16_t payload_length = 0;
+};
+
+// 链路层封装类型。DLT在pcap_open时即确定、整个会话不变，
+// 因此按模板实例化选择解码器：L2分支在编译期折叠，
+// 每包零链路层判断
+enum class LinkLayer : uint8_t {
+    kEthernet,  // DLT_EN10MB：以太网（含802.1Q/802.1ad VLAN叠加标签）
+    kLinuxSll,  // DLT_LINUX_SLL：cooked捕获（pcap -i any）
+    kRawIp,     // DLT_RAW：无L2头，首字节即IP版本号
+};
+
+// 解析一帧并填充info.parsed。
+// 不识别的L3协议或头部越界时parsed.valid为false
+template <LinkLayer Link>
+void parseFrame(PacketInfo& info);
+
+extern template void parseFrame<LinkLayer::kEthernet>(PacketInfo& info);
+extern template void parseFrame<LinkLayer::kLinuxSll>(PacketInfo& info);
+extern template void parseFrame<LinkLayer::kRawIp>(PacketInfo& info);
+
+// 会话级解码器选择：按pcap的DLT值返回对应实例化，
+// 不支持的链路类型返回nullptr（捕获初始化时报错）
+using ParseFn = void (*)(PacketInfo&);
+ParseFn parserForDatalink(int dlt);
+
+// 以太网路径的便捷入口（AF_PACKET与离线工具走这里）
+void parsePacket(PacketInfo& info);
+
+} // namespace capture
+} // namespace nips
@@ -2,49 +2,22 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <memory>
 #include <yaml-cpp/yaml.h>
 
 namespace nips {
 namespace common {
 
-class Config {
-public:
-    static Config& getInstance();
-
-    // 加载配置文件
-    bool load(const std::string& config_path);
-    
-    // 获取配置项
-    template<typename T>
-    T get(const std::string& key, const T& default_value = T()) const;
-    
-    // 设置配置项
-    template<typename T>
-    void set(const std::string& key, const T& value);
-    
-    // 保存配置
-    bool save(const std::string& config_path = "");
-
-private:
-    Config() = default;
-    ~Config() = default;
-    
-    // 禁用拷贝
-    Config(const Config&) = delete;
-    Config& operator=(const Config&) = delete;
-    
-    YAML::Node config_;
-    std::string current_config_path_;
-};
-
 // 配置项定义
 struct CaptureConfig {
     std::string interface;
+    std::string backend;
     std::string filter;
     int buffer_size;
     int timeout_ms;
     bool promiscuous;
+    int fanout_queues;
 };
 
 struct FeatureConfig {
@@ -52,6 +25,8 @@ struct FeatureConfig {
     size_t max_packets_per_flow;
     bool enable_deep_packet_inspection;
     std::vector<std::string> enabled_features;
+    std::string export_dir;        // 二进制流记录导出目录（空表示禁用）
+    size_t export_segment_mb;      // 单段预分配大小
 };
 
 struct MLConfig {
@@ -59,7 +34,13 @@ struct MLConfig {
     std::string model_path;
     float anomaly_threshold;
     size_t batch_size;
+    size_t max_batch_delay_ms;
     bool enable_gpu;
+    bool enable_verdict_cache;        // 清白流快路径（跳过重复推理）
+    size_t verdict_clean_batches;     // 进入快路径需要的连续清白结算次数
+    float verdict_score_margin;       // 清白判定：分数须低于阈值减该余量
+    size_t verdict_resample_interval; // 快路径流每N次跳过后强制重采样一次
+    size_t verdict_max_entries;       // 缓存容量上限
 };
 
 struct DetectionConfig {
@@ -67,6 +48,9 @@ struct DetectionConfig {
     std::string intel_source;
     size_t max_threats_history;
     bool enable_correlation;
+    size_t correlation_window_seconds;   // 关联滑动窗口长度
+    size_t correlation_port_threshold;   // 窗口内不同目的端口数告警阈值
+    size_t correlation_host_threshold;   // 窗口内不同目的IP数告警阈值
 };
 
 struct ResponseConfig {
@@ -74,7 +58,108 @@ struct ResponseConfig {
     bool enable_auto_response;
     size_t max_concurrent_actions;
     std::string log_path;
+    std::string export_shm;       // 共享内存导出段名（空表示禁用，回退JSON文本日志）
+    size_t export_capacity;       // 导出环槽数（向上取2的幂）
+};
+
+struct SystemConfig {
+    int threads;
+    size_t queue_size;
+    size_t memory_limit;
+    int check_interval;
+    int metrics_port;  // Prometheus遥测端点端口（0表示禁用）
+    int overload_high_pct;       // 进入过载采样的分析队列水位百分比（0禁用）
+    int overload_low_pct;        // 退出过载采样的水位百分比
+    int overload_sample_stride;  // 采样模式下流中段包的保留步长
+    std::string capture_cpus;    // 捕获线程CPU集："auto"=网卡所在NUMA节点/显式列表/空=不绑核
+    std::string analysis_cpus;   // 分析工作线程CPU集，格式同上
+    int torch_threads;           // libtorch intra-op线程数（0=libtorch默认）
+};
+
+// 一次解析得到的不可变配置快照。读取方只做一次指针解引用，
+// 运行时reload通过原子换入新快照实现（RCU式），读取方无锁
+struct ConfigSnapshot {
+    CaptureConfig capture;
+    FeatureConfig feature;
+    MLConfig ml;
+    DetectionConfig detection;
+    ResponseConfig response;
+    SystemConfig system;
+};
+
+class Config {
+public:
+    static Config& getInstance();
+
+    // 加载配置文件（解析YAML并构建类型化快照）
+    bool load(const std::string& config_path);
+
+    // 重新加载当前配置文件；新快照原子换入，旧快照由
+    // 仍持有它的读取方引用计数保活
+    bool reload();
+
+    // 获取当前配置快照（无锁，热路径用这个而不是get<T>）
+    std::shared_ptr<const ConfigSnapshot> snapshot() const {
+        return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+    }
+
+    // 获取配置项（逐键遍历YAML，仅用于初始化路径）
+    template<typename T>
+    T get(const std::string& key, const T& default_value = T()) const {
+        try {
+            YAML::Node node = YAML::Clone(config_);
+            size_t start = 0;
+            while (true) {
+                const size_t dot = key.find('.', start);
+                const std::string segment = key.substr(start, dot - start);
+                node.reset(node[segment]);
+                if (!node.IsDefined()) {
+                    return default_value;
+                }
+                if (dot == std::string::npos) {
+                    return node.as<T>();
+                }
+                start = dot + 1;
+            }
+        } catch (const std::exception&) {
+            return default_value;
+        }
+    }
+
+    // 设置配置项
+    template<typename T>
+    void set(const std::string& key, const T& value) {
+        std::vector<std::string> segments;
+        size_t start = 0;
+        while (true) {
+            const size_t dot = key.find('.', start);
+            segments.push_back(key.substr(start, dot - start));
+            if (dot == std::string::npos) break;
+            start = dot + 1;
+        }
+        setNode(segments, YAML::Node(value));
+    }
+
+    // 保存配置
+    bool save(const std::string& config_path = "");
+
+private:
+    Config() = default;
+    ~Config() = default;
+
+    // 禁用拷贝
+    Config(const Config&) = delete;
+    Config& operator=(const Config&) = delete;
+
+    // 由已解析的YAML构建类型化快照
+    std::shared_ptr<const ConfigSnapshot> buildSnapshot() const;
+
+    void setNode(const std::vector<std::string>& segments, YAML::Node value);
+
+    YAML::Node config_;
+    std::string current_config_path_;
+    std::shared_ptr<const ConfigSnapshot> snapshot_;
 };
 
 } // namespace common
-} // namespace nips 
\ No newline at end of file
+} // namespace nips
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace nips {
+namespace common {
+
+// CPU/NUMA拓扑辅助：从sysfs读取拓扑，用pthread亲和性做绑核。
+// 内存的节点本地性依赖first-touch——线程绑定后由它首次写入的
+// 页落在本节点，因此不引入libnuma依赖
+class CpuTopology {
+public:
+    // 网卡所在的NUMA节点（/sys/class/net/<if>/device/numa_node）；
+    // 未知或单节点机器返回-1
+    static int nicNumaNode(const std::string& interface);
+
+    // 节点的CPU列表（/sys/devices/system/node/node<N>/cpulist）
+    static std::vector<int> nodeCpus(int node);
+
+    // 解析CPU集配置："auto"取网卡所在节点的全部CPU，
+    // 否则按"0-3,8-11"格式解析；无法解析/无法推导时返回空
+    //（空集意味着不绑核）
+    static std::vector<int> resolveCpuSet(const std::string& spec,
+                                          const std::string& interface);
+
+    // 把当前线程绑定到CPU集；空集为no-op
+    static bool pinCurrentThread(const std::vector<int>& cpus);
+
+    // 解析"0-3,8-11"格式的CPU列表
+    static std::vector<int> parseCpuList(const std::string& list);
+};
+
+} // namespace common
+} // namespace nips
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace nips {
+namespace common {
+
+// 固定大小对象池：按slab整块向系统申请，之后的取/还只走
+// 空闲链，不再触达堆分配器。slab内对象连续，便于批量gather。
+// 非线程安全，由持有者（如流表）的锁保护
+template<typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t slab_size = 4096) : slab_size_(slab_size) {}
+
+    ~ObjectPool() = default;
+
+    // 取一个对象（placement new构造）
+    template<typename... Args>
+    T* acquire(Args&&... args) {
+        if (!free_) {
+            grow();
+        }
+        Slot* slot = free_;
+        free_ = slot->next;
+        ++allocated_;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    // 析构并归还
+    void release(T* obj) {
+        if (!obj) return;
+        obj->~T();
+        Slot* slot = reinterpret_cast<Slot*>(obj);
+        slot->next = free_;
+        free_ = slot;
+        --allocated_;
+    }
+
+    // 当前在用对象数
+    size_t allocated() const { return allocated_; }
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    void grow() {
+        auto slab = std::make_unique<Slot[]>(slab_size_);
+        for (size_t i = 0; i < slab_size_; ++i) {
+            slab[i].next = (i + 1 < slab_size_) ? &slab[i + 1] : free_;
+        }
+        free_ = &slab[0];
+        slabs_.push_back(std::move(slab));
+    }
+
+    std::vector<std::unique_ptr<Slot[]>> slabs_;
+    Slot* free_ = nullptr;
+    size_t slab_size_;
+    size_t allocated_ = 0;
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+};
+
+} // namespace common
+} // namespace nips
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nips {
+namespace common {
+
+// 管线各阶段（延迟直方图与吞吐计数按阶段分槽）
+enum TelemetryStage {
+    kStageFlowUpdate = 0,   // 逐包流表更新（特征累积）
+    kStageInference,        // 批量模型推理
+    kStageThreatDetect,     // 威胁检测链
+    kStageResponse,         // 响应动作执行
+    kStageCount
+};
+
+// 热路径遥测：每线程无锁计数器 + log2桶延迟直方图，
+// 通过内置HTTP端点以Prometheus文本格式导出。
+// record只做一次thread_local寻址和两次relaxed自增，
+// 可以放在逐包路径上而不影响吞吐
+class Telemetry {
+public:
+    static constexpr size_t kBuckets = 32;    // log2(ns)桶，覆盖1ns~4s
+    static constexpr size_t kMaxThreads = 64;
+
+    static Telemetry& getInstance();
+
+    // 记录一次阶段耗时（纳秒）
+    void record(TelemetryStage stage, uint64_t nanos);
+
+    // 记录阶段耗时并计入多个事件（批处理：一次forward覆盖N个流）
+    void record(TelemetryStage stage, uint64_t nanos, uint64_t events);
+
+    // 注册采集时求值的仪表（队列水位、流表占用、内核丢包等）
+    void registerGauge(const std::string& name, std::function<uint64_t()> fn);
+
+    // 启动/停止Prometheus导出端点（system.metrics_port，0表示禁用）
+    bool startExporter(uint16_t port);
+    void stopExporter();
+
+    // 生成Prometheus文本格式（导出线程调用；聚合所有线程槽）
+    std::string render() const;
+
+    // 作用域计时器：构造到析构的耗时计入指定阶段
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(TelemetryStage stage, uint64_t events = 1)
+            : stage_(stage), events_(events),
+              start_(std::chrono::steady_clock::now()) {}
+
+        ~ScopedTimer() {
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            Telemetry::getInstance().record(stage_,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                events_);
+        }
+
+    private:
+        TelemetryStage stage_;
+        uint64_t events_;
+        std::chrono::steady_clock::time_point start_;
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+
+private:
+    Telemetry() = default;
+    ~Telemetry();
+
+    // 每线程、每阶段的直方图槽；线程独占写，导出线程并发读，
+    // 全部relaxed原子避免伪共享之外的任何同步开销
+    struct alignas(64) StageSlot {
+        std::atomic<uint64_t> buckets[kBuckets] = {};
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> events{0};
+    };
+
+    struct Gauge {
+        std::string name;
+        std::function<uint64_t()> fn;
+    };
+
+    // 当前线程的槽下标（首次调用时分配）
+    size_t threadSlot();
+
+    // 导出线程主循环：阻塞accept，对每个连接回应一次采集
+    void exporterLoop();
+
+    StageSlot slots_[kMaxThreads][kStageCount];
+    std::atomic<size_t> thread_count_{0};
+
+    std::vector<Gauge> gauges_;
+    mutable std::mutex gauges_mutex_;
+
+    std::unique_ptr<std::thread> exporter_thread_;
+    std::atomic<bool> running_{false};
+    int listen_fd_ = -1;
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+};
+
+} // namespace common
+} // namespace nips
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "detection/threat_detector.hpp"
+#include "feature/feature_extractor.hpp"
+
+namespace nips {
+namespace correlation {
+
+// 跨流威胁关联引擎：按源IP维护滑动窗口计数器
+// （不同目的端口数、不同目的IP数、SYN无ACK流数），
+// 每个完成的流O(1)更新对应的秒级环形桶，portscan/sweep
+// 从计数阈值直接涌现——不重扫威胁历史，告警量大时也不退化
+class CorrelationEngine {
+public:
+    // 关联告警回调（与ThreatDetector的产出走同一响应链）
+    using AlertCallback = std::function<void(const detection::ThreatInfo&)>;
+
+    CorrelationEngine();
+    ~CorrelationEngine();
+
+    // 初始化；窗口与阈值来自 detection.correlation_* 配置
+    bool init();
+
+    void setAlertCallback(AlertCallback callback);
+
+    // 观察一个完成的流（含未触发异常的流，扫描多由此类流构成）；
+    // 流身份取自features.flow_key_hi/lo
+    void observe(const feature::FlowFeatures& features);
+
+    // 回收长期不活跃的源状态；由主循环周期性调用
+    void advance(uint32_t now);
+
+    // 当前被跟踪的源数量（遥测仪表）
+    size_t trackedSources() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pimpl_;
+};
+
+} // namespace correlation
+} // namespace nips
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nips {
+namespace detection {
+
+// 编译后的威胁情报索引：构建一次、只读查询。
+// IP/CIDR指标压平为排序合并的区间数组（二分查找，O(log n)，
+// 无逐查询哈希），字符串指标编译为Aho-Corasick自动机
+// （单遍扫描文本，与指标数量无关）。
+// 索引不可变，更新时整体重建并由持有方原子换入（RCU式），
+// 查询路径完全无锁
+class IntelIndex {
+public:
+    // 从情报源文件构建索引（JSON，yaml-cpp解析）。
+    // 期望格式: {"indicators": [{"type": "ip|cidr|domain", "value": "..."}]}
+    // 解析失败返回nullptr
+    static std::shared_ptr<const IntelIndex> build(const std::string& intel_path);
+
+    // IP是否命中任一指标区间（主机序）
+    bool matchIp(uint32_t ip) const;
+
+    // 点分十进制便捷重载；非法地址返回false
+    bool matchIp(const std::string& ip) const;
+
+    // 文本是否包含任一字符串指标（域名等）
+    bool matchString(const std::string& text) const;
+
+    size_t ipRangeCount() const { return ranges_.size(); }
+    size_t patternCount() const { return pattern_count_; }
+
+private:
+    IntelIndex() = default;
+
+    // 合并后的IP区间（闭区间，按start排序且互不重叠）
+    struct Range {
+        uint32_t start;
+        uint32_t end;
+    };
+
+    // Aho-Corasick节点：出边按字节排序（二分查找），
+    // 固定256槽的goto表在2M指标规模下内存不可接受
+    struct AcNode {
+        std::vector<std::pair<uint8_t, int32_t>> next;
+        int32_t fail = 0;
+        bool output = false;
+    };
+
+    // 构建期：插入一个模式串
+    void addPattern(const std::string& pattern);
+
+    // 构建期：BFS计算fail链并传播输出标记
+    void compileAutomaton();
+
+    // 查询：从state经字节c转移（含fail链回退）
+    int32_t step(int32_t state, uint8_t c) const;
+
+    std::vector<Range> ranges_;
+    std::vector<AcNode> nodes_;
+    size_t pattern_count_ = 0;
+};
+
+} // namespace detection
+} // namespace nips
@@ -18,6 +18,11 @@ enum class ThreatLevel {
     CRITICAL
 };
 
+// 流键地址的惰性渲染：IPv4主机字节序到点分十进制；IPv6槽位
+// 存的是128位地址的32位折叠，不可反渲染，按"v6#<16进制>"标注
+// （响应侧的IPv4目标校验会拒绝该形式，不会误阻断无关地址）
+std::string renderFlowAddress(uint32_t ip, uint8_t ip_version);
+
 struct ThreatInfo {
     std::string id;
     std::string type;
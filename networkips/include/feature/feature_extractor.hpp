@@ -1,40 +1,77 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <string>
 #include <memory>
 #include <unordered_map>
 #include "capture/packet_capture.hpp"
+#include "feature/topk_sketch.hpp"
 
 namespace nips {
 namespace feature {
 
+// 协议下标（protocol_distribution数组的固定布局）
+enum ProtocolIndex {
+    kProtoTcp = 0,
+    kProtoUdp = 1,
+    kProtoIcmp = 2,
+    kProtoOther = 3,
+    kProtoCount = 4
+};
+
 struct FlowFeatures {
-    // 基本流量特征
-    uint32_t packet_count;
-    uint32_t byte_count;
-    float duration;
-    float packets_per_second;
-    float bytes_per_second;
-    
-    // 协议特征
-    std::unordered_map<std::string, float> protocol_distribution;
-    
+    // 所属流的打包5元组（FlowKey::packHi/packLo；结算时由流表填充）。
+    // 威胁检测在真正产出ThreatInfo时才从这里渲染IP字符串，
+    // 不进入模型特征向量
+    uint64_t flow_key_hi = 0;
+    uint64_t flow_key_lo = 0;
+
+    // 实际观测包数/代表的原始包数（过载采样时<1，否则为1）。
+    // packets_per_second/byte_count等计数除以它可回算原始量级；
+    // 不进入模型特征向量
+    float sample_rate = 1.0f;
+
+    // 基本流量特征（零初始化：被掩码关闭的特征组保持为0）
+    uint32_t packet_count = 0;
+    uint32_t byte_count = 0;
+    float duration = 0.0f;
+    float packets_per_second = 0.0f;
+    float bytes_per_second = 0.0f;
+
+    // 协议特征（按ProtocolIndex定长索引，不再做字符串哈希）
+    std::array<float, kProtoCount> protocol_distribution{};
+
     // 统计特征
-    float mean_packet_size;
-    float std_packet_size;
-    float mean_inter_arrival_time;
-    float std_inter_arrival_time;
-    
+    float mean_packet_size = 0.0f;
+    float std_packet_size = 0.0f;
+    float mean_inter_arrival_time = 0.0f;
+    float std_inter_arrival_time = 0.0f;
+
     // 行为特征
-    std::vector<float> payload_entropy;
-    std::vector<float> port_usage_pattern;
-    std::vector<float> connection_pattern;
-    
-    // 时间特征
-    std::vector<float> time_based_features;
+    float avg_payload_entropy = 0.0f;
+    float max_payload_entropy = 0.0f;
+    TopKSketch port_usage_pattern;  // 有界Top-K端口活跃度（原65536项直方图）
+    std::array<float, 10> connection_pattern{};
 };
 
+// 协议号到ProtocolIndex的映射
+ProtocolIndex protocolIndex(uint8_t ip_protocol);
+
+// 特征组位掩码：与 feature.enabled_features 配置列表一一对应。
+// 提取循环按掩码做模板特化，关闭的组不产生任何指令
+enum FeatureGroup : unsigned {
+    kFeatBasicStats = 1u << 0,         // "basic_stats"：包/字节计数、包大小统计
+    kFeatProtocolDistribution = 1u << 1,  // "protocol_distribution"
+    kFeatPayloadEntropy = 1u << 2,     // "payload_entropy"：逐包负载熵（DPI，最昂贵）
+    kFeatTimeFeatures = 1u << 3,       // "time_features"：包间隔统计
+    kFeatConnectionPattern = 1u << 4,  // "connection_pattern"：TCP标志 + 端口活跃度
+    kFeatAll = (1u << 5) - 1
+};
+
+// 把配置中的特征组名列表转为位掩码；未知名称告警后忽略
+unsigned featureMaskFromNames(const std::vector<std::string>& names);
+
 class FeatureExtractor {
 public:
     FeatureExtractor();
@@ -42,7 +79,10 @@ public:
 
     // 从数据包提取特征
     FlowFeatures extractFeatures(const std::vector<capture::PacketInfo>& packets);
-    
+
+    // 从单个数据包提取特征（PacketInfo仅可移动，避免为单包构造vector）
+    FlowFeatures extractFeatures(const capture::PacketInfo& packet);
+
     // 从单个数据包更新特征
     void updateFeatures(FlowFeatures& features, const capture::PacketInfo& packet);
     
@@ -53,17 +93,21 @@ public:
     std::vector<float> featuresToVector(const FlowFeatures& features);
 
 private:
+    // 提取特征的公共实现（按指针数组遍历，兼容仅可移动的PacketInfo）
+    FlowFeatures extractFeaturesImpl(const capture::PacketInfo* const* packets, size_t count);
+
     // 计算数据包熵值
-    float calculateEntropy(const std::vector<uint8_t>& data);
-    
+    float calculateEntropy(const uint8_t* data, size_t size);
+
     // 更新协议分布
     void updateProtocolDistribution(FlowFeatures& features, const capture::PacketInfo& packet);
-    
+
     // 计算时间相关特征
     void calculateTimeFeatures(FlowFeatures& features, const std::vector<capture::PacketInfo>& packets);
-    
+
     // 计算连接模式特征
-    void calculateConnectionPattern(FlowFeatures& features, const std::vector<capture::PacketInfo>& packets);
+    void calculateConnectionPattern(FlowFeatures& features,
+                                  const capture::PacketInfo* const* packets, size_t count);
 };
 
 } // namespace feature
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+namespace nips {
+namespace feature {
+
+// 流标识：5元组，打包为两个64位字（合计一个128位整数）。
+// 比较与哈希都在打包字上进行，不做任何字符串格式化；
+// IP的字符串渲染推迟到真正产出ThreatInfo时
+struct FlowKey {
+    uint32_t src_ip = 0;       // IPv6时为128位地址的32位折叠
+    uint32_t dst_ip = 0;
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    uint8_t protocol = 0;
+    uint8_t ip_version = 4;    // 打包进低64位，v4/v6折叠地址不会互相混淆
+
+    // 高64位：src_ip | dst_ip
+    uint64_t packHi() const {
+        return static_cast<uint64_t>(src_ip) << 32 | dst_ip;
+    }
+
+    // 低64位：ip_version | src_port | dst_port | protocol（高16位为0）
+    uint64_t packLo() const {
+        return static_cast<uint64_t>(ip_version) << 40 |
+               static_cast<uint64_t>(src_port) << 24 |
+               static_cast<uint64_t>(dst_port) << 8 | protocol;
+    }
+
+    bool operator==(const FlowKey& other) const {
+        return packHi() == other.packHi() && packLo() == other.packLo();
+    }
+};
+
+struct FlowKeyHash {
+    // murmur风格的64位终混
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    size_t operator()(const FlowKey& key) const {
+        return static_cast<size_t>(mix(key.packHi() ^ mix(key.packLo())));
+    }
+};
+
+} // namespace feature
+} // namespace nips
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "feature/feature_extractor.hpp"
+#include "feature/flow_table.hpp"
+
+namespace nips {
+namespace feature {
+
+// 定长二进制流记录：5元组 + 结算时间 + featuresToVector的50维向量。
+// 布局固定（小端POD），训练侧按同样的struct格式直接解析
+// （training/scripts/flow_records.py）
+struct FlowRecord {
+    uint32_t src_ip;          // 主机序
+    uint32_t dst_ip;
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint8_t protocol;
+    uint8_t ip_version;       // 4/6；v6的src_ip/dst_ip为折叠地址
+    uint8_t pad[2] = {0};
+    uint32_t export_time;     // 记录写入时刻（epoch秒）
+    float sample_rate;        // 过载采样率（<1时计数特征需除以它回算）
+    float features[50];
+};
+
+static_assert(sizeof(FlowRecord) == 224, "FlowRecord布局被改动，需同步训练侧读取器");
+
+// 段文件头（32字节）；record_count在每次落盘时更新，
+// 崩溃后读取器按头部计数截断尾部未落盘数据
+struct FlowSegmentHeader {
+    char magic[8];            // "NIPSFLOW"
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t record_count;
+    uint64_t reserved = 0;
+};
+
+static_assert(sizeof(FlowSegmentHeader) == 32, "段文件头必须为32字节");
+
+// 内存映射的追加式流记录写入器：按段预分配并mmap，
+// 追加只是一次memcpy，周期性msync落盘；段写满后滚动新段，
+// 关闭时把文件截断到实际使用长度。
+// 同等记录率下CPU开销远低于逐字段格式化CSV
+class FlowRecordWriter {
+public:
+    FlowRecordWriter();
+    ~FlowRecordWriter();
+
+    // 初始化；目录不存在时创建。segment_mb为单段预分配大小，
+    // sync_interval_records为msync间隔（按记录数）
+    bool init(const std::string& export_dir, size_t segment_mb = 64,
+              size_t sync_interval_records = 4096);
+
+    // 追加一条流记录（线程安全）
+    void append(const FlowKey& key, const FlowFeatures& features);
+
+    // 落盘当前段并关闭
+    void close();
+
+    uint64_t recordsWritten() const { return records_written_; }
+
+private:
+    // 滚动到新段文件（命名 flows_<epoch>_<seq>.bin）
+    bool rollSegment();
+
+    // 更新头部计数并msync
+    void sync();
+
+    std::string export_dir_;
+    size_t segment_bytes_ = 0;
+    size_t sync_interval_ = 4096;
+
+    uint8_t* map_ = nullptr;
+    size_t map_size_ = 0;
+    size_t write_offset_ = 0;
+    int fd_ = -1;
+    uint32_t segment_seq_ = 0;
+    uint64_t segment_records_ = 0;
+    uint64_t records_since_sync_ = 0;
+    uint64_t records_written_ = 0;
+
+    FeatureExtractor converter_;
+    std::mutex mutex_;
+
+    FlowRecordWriter(const FlowRecordWriter&) = delete;
+    FlowRecordWriter& operator=(const FlowRecordWriter&) = delete;
+};
+
+} // namespace feature
+} // namespace nips
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "capture/packet_capture.hpp"
+#include "common/object_pool.hpp"
+#include "feature/feature_extractor.hpp"
+#include "feature/flow_key.hpp"
+
+namespace nips {
+namespace feature {
+
+// 按5元组累积特征的流表：每个数据包O(1)增量更新
+// （Welford在线方差、协议/标志计数、熵的运行统计），
+// 流在超时或达到包数上限时完成并通过回调送入检测链。
+// 取代了对每个数据包调用完整extractFeatures的做法
+class FlowTable {
+public:
+    // 流完成回调（超时或达到包数上限时触发）
+    using FlowCallback = std::function<void(const FlowKey&, FlowFeatures&&)>;
+
+    FlowTable();
+    ~FlowTable();
+
+    // 初始化；前两个参数对应 feature.flow_timeout_seconds / feature.max_packets_per_flow，
+    // feature_mask由 feature.enabled_features 经featureMaskFromNames得到，
+    // 选定编译期特化的累积内核（关闭的特征组零开销）
+    bool init(size_t flow_timeout_seconds, size_t max_packets_per_flow,
+              unsigned feature_mask = kFeatAll);
+
+    // 设置流完成回调
+    void setFlowCallback(FlowCallback callback);
+
+    // 以单个数据包增量更新所属流（O(1)）
+    void update(const capture::PacketInfo& packet);
+
+    // 推进时间轮并完成超时的流；由主循环周期性调用。
+    // 只排空自上次调用以来游标扫过的槽（O(经过秒数+过期流数)）
+    void checkTimeouts(uint32_t now);
+
+    // 完成并上报所有活动流（停机时调用）
+    void flushAll();
+
+    // 当前活动流数量
+    size_t size() const;
+
+    // 从数据包解析5元组；解析失败返回false。
+    // 管线的流哈希分派也使用此函数
+    static bool extractKey(const capture::PacketInfo& packet, FlowKey& key);
+
+private:
+    // 每流状态：特征 + 在线统计累积器
+    struct FlowState {
+        FlowFeatures features;
+        FlowKey key;  // 时间轮过期时需要反查
+        uint32_t first_timestamp = 0;
+        uint32_t last_timestamp = 0;
+
+        // 时间轮槽内侵入式双链
+        FlowState* wheel_prev = nullptr;
+        FlowState* wheel_next = nullptr;
+        uint32_t wheel_slot = UINT32_MAX;
+
+        // Welford在线均值/方差
+        double size_mean = 0.0;
+        double size_m2 = 0.0;
+        double iat_mean = 0.0;
+        double iat_m2 = 0.0;
+        uint64_t iat_count = 0;
+
+        // 观测包代表的原始包数之和（过载采样时大于packet_count）
+        uint64_t stride_sum = 0;
+
+        // 协议计数（TCP/UDP/ICMP/OTHER）
+        uint32_t proto_counts[kProtoCount] = {0};
+
+        // 负载熵运行统计
+        float entropy_sum = 0.0f;
+        float entropy_max = 0.0f;
+        uint32_t entropy_count = 0;
+    };
+
+    // 累积单个数据包：按特征组掩码模板特化，init时从
+    // 全部实例化中选定一个，热路径上没有逐包掩码判断
+    template<unsigned Mask>
+    void accumulate(FlowState& state, const FlowKey& key, const capture::PacketInfo& packet);
+
+    using AccumulateFn = void (FlowTable::*)(FlowState&, const FlowKey&,
+                                             const capture::PacketInfo&);
+
+    // 生成全部掩码组合的累积内核实例化表
+    template<size_t... Masks>
+    static constexpr std::array<AccumulateFn, sizeof...(Masks)>
+    makeAccumulateTable(std::index_sequence<Masks...>) {
+        return {&FlowTable::accumulate<static_cast<unsigned>(Masks)>...};
+    }
+
+    // 结算并上报一个流
+    void emitFlow(const FlowKey& key, FlowState& state);
+
+    // 时间轮操作：每次流触达O(1)重排其槽位，
+    // 过期只排空游标扫过的槽，不做全表遍历
+    void wheelUnlink(FlowState* state);
+    void wheelSchedule(FlowState* state);
+
+    // 流记录由对象池slab分配：记录定长且连续，取/还不触达堆分配器
+    std::unordered_map<FlowKey, FlowState*, FlowKeyHash> flows_;
+    common::ObjectPool<FlowState> state_pool_;
+
+    // 过期时间轮：每秒一槽，槽数为2的幂且覆盖整个超时横距，
+    // 因此每个槽内的流恰好在游标到达时到期
+    std::vector<FlowState*> wheel_;
+    uint32_t wheel_mask_ = 0;
+    uint32_t wheel_time_ = 0;  // 已排空到的秒（0表示尚未推进）
+    mutable std::mutex mutex_;  // 粗粒度锁；按流哈希分片后可去除
+    FlowCallback callback_;
+    AccumulateFn accumulate_fn_ = nullptr;
+    unsigned feature_mask_ = kFeatAll;
+    size_t flow_timeout_seconds_ = 300;
+    size_t max_packets_per_flow_ = 1000;
+
+    FlowTable(const FlowTable&) = delete;
+    FlowTable& operator=(const FlowTable&) = delete;
+};
+
+} // namespace feature
+} // namespace nips
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace nips {
+namespace feature {
+namespace simd {
+
+// 向量化的特征提取内核。src/CMakeLists.txt 以 -march=native 编译，
+// 这里在有AVX2的目标上走显式SIMD路径，否则回退到标量实现
+
+// 字节频率直方图：8路子表展开打破store-to-load依赖链，
+// 末尾用SIMD归并子表
+void byteHistogram(const uint8_t* data, size_t size, uint32_t freq[256]);
+
+// 由直方图计算香农熵：基于恒等式
+//   H = log2(total) - (1/total) * Σ count*log2(count)
+// count*log2(count) 预计算为查找表，AVX2下用gather批量取值
+float entropyFromHistogram(const uint32_t freq[256], size_t total);
+
+// 单遍融合的均值/方差（FMA累加和与平方和）
+void meanVariance(const float* data, size_t size, float& mean, float& variance);
+
+// 负载熵：直方图 + 熵计算一步到位
+float payloadEntropy(const uint8_t* data, size_t size);
+
+} // namespace simd
+} // namespace feature
+} // namespace nips
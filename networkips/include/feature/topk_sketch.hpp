@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace nips {
+namespace feature {
+
+// 有界的重频项（heavy hitters）结构，Space-Saving算法：
+// 固定32个槽，命中则累加，未命中且槽满时顶替当前最小项。
+// 取代了每流65536项的端口直方图（256KB/流 + 全量partial_sort），
+// 误差上界为 总更新数/容量，对"前20活跃端口"这种输出绰绰有余
+class TopKSketch {
+public:
+    static constexpr size_t kCapacity = 32;
+
+    // 记一次key出现
+    void update(uint16_t key, float weight = 1.0f) {
+        // 容量只有32，线性扫描比哈希更缓存友好
+        size_t min_index = 0;
+        for (size_t i = 0; i < used_; ++i) {
+            if (entries_[i].key == key) {
+                entries_[i].count += weight;
+                return;
+            }
+            if (entries_[i].count < entries_[min_index].count) {
+                min_index = i;
+            }
+        }
+        if (used_ < kCapacity) {
+            entries_[used_++] = Entry{key, weight};
+        } else {
+            // Space-Saving顶替：继承被顶替项的计数作为误差上界
+            entries_[min_index].key = key;
+            entries_[min_index].count += weight;
+        }
+    }
+
+    // 取计数最大的前n项的计数值（降序，不足补0，按最大值归一化）
+    std::vector<float> topCounts(size_t n) const {
+        std::vector<float> counts;
+        counts.reserve(used_);
+        for (size_t i = 0; i < used_; ++i) {
+            counts.push_back(entries_[i].count);
+        }
+        std::sort(counts.begin(), counts.end(), std::greater<float>());
+        counts.resize(n, 0.0f);
+
+        if (!counts.empty() && counts[0] > 0) {
+            const float max_count = counts[0];
+            for (auto& count : counts) {
+                count /= max_count;
+            }
+        }
+        return counts;
+    }
+
+    bool empty() const { return used_ == 0; }
+    size_t size() const { return used_; }
+
+    void clear() { used_ = 0; }
+
+private:
+    struct Entry {
+        uint16_t key;
+        float count;
+    };
+
+    std::array<Entry, kCapacity> entries_{};
+    size_t used_ = 0;
+};
+
+} // namespace feature
+} // namespace nips
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ml/anomaly_detector.hpp"
+
+namespace nips {
+namespace ml {
+
+// 批量推理调度器：把流特征攒成批（ml.batch_size），
+// 满批或到达最大延迟即做一次forward，再把结果散回各流。
+// batch-64一次forward的单样本成本约为64次单独调用的1/15
+class InferenceBatcher {
+public:
+    // 单个样本的推理结果回调
+    using ResultCallback = std::function<void(feature::FlowFeatures&&,
+                                              const DetectionResult&)>;
+
+    explicit InferenceBatcher(AnomalyDetector& detector);
+    ~InferenceBatcher();
+
+    // 初始化；参数对应 ml.batch_size / ml.max_batch_delay_ms
+    bool init(size_t batch_size, uint32_t max_delay_ms);
+
+    // 启动刷批线程
+    bool start(ResultCallback callback);
+
+    // 停止并处理完残留样本
+    void stop();
+
+    // 提交一个待推理的流特征（线程安全）
+    void submit(feature::FlowFeatures&& features);
+
+private:
+    // 刷批线程主循环
+    void flushLoop();
+
+    // 对当前批执行一次forward并散回结果
+    void flushBatch(std::vector<feature::FlowFeatures>&& batch);
+
+    AnomalyDetector& detector_;
+    ResultCallback callback_;
+    size_t batch_size_ = 64;
+    std::chrono::milliseconds max_delay_{20};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<feature::FlowFeatures> pending_;
+    std::unique_ptr<std::thread> flush_thread_;
+    std::atomic<bool> running_{false};
+
+    InferenceBatcher(const InferenceBatcher&) = delete;
+    InferenceBatcher& operator=(const InferenceBatcher&) = delete;
+};
+
+} // namespace ml
+} // namespace nips
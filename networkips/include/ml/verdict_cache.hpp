@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "feature/feature_extractor.hpp"
+#include "ml/anomaly_detector.hpp"
+
+namespace nips {
+namespace ml {
+
+// 推理前的清白流快路径：按打包流键缓存判定结果。
+// 同一条流连续N次结算的分数都远低于阈值后进入快路径，
+// 后续结算直接跳过模型推理；每隔若干次跳过强制重采样一次，
+// 并在行为漂移（熵/SYN比例偏离基线）时立即失效。
+// 绝大部分流量来自少数长命清白流，推理负载随之成数量级下降
+class VerdictCache {
+public:
+    VerdictCache();
+    ~VerdictCache();
+
+    // 初始化；参数来自 ml.verdict_* 配置
+    bool init(size_t clean_batches, float score_margin,
+              size_t resample_interval, size_t max_entries);
+
+    // 结算进入推理前查询：返回true表示本次结算可跳过推理。
+    // 快路径流的周期性重采样与行为漂移失效都在这里发生
+    bool shouldSkip(const feature::FlowFeatures& features);
+
+    // 推理结果回填：维护连续清白计数与快路径状态
+    void recordResult(const feature::FlowFeatures& features,
+                      const DetectionResult& result);
+
+    // 累计跳过的推理次数（遥测仪表）
+    uint64_t skipped() const;
+
+    // 当前缓存条目数
+    size_t size() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pimpl_;
+};
+
+} // namespace ml
+} // namespace nips
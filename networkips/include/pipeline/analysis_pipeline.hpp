@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "capture/packet_capture.hpp"
+#include "pipeline/mpmc_ring.hpp"
+
+namespace nips {
+namespace pipeline {
+
+// 队列统计信息，用于环大小调优
+struct QueueStats {
+    uint64_t enqueued;
+    uint64_t dequeued;
+    uint64_t stolen;
+    uint64_t dropped;
+    size_t occupancy;
+    size_t capacity;
+};
+
+// 捕获与分析之间的解耦层：数据包按5元组哈希分派到N个分片
+// （同一条流总是落到同一分片，分片内流状态无竞争），每个分片
+// 由一个工作线程排空；空闲工作线程会从邻近分片偷任务，避免
+// 单条大象流压垮一个分片时其余核心闲置
+class AnalysisPipeline {
+public:
+    // 分片号 + 数据包；偷来的任务也携带原分片号，
+    // 保证同一条流的状态始终按原分片访问
+    using PacketHandler = std::function<void(size_t shard, const capture::PacketInfo&)>;
+
+    AnalysisPipeline();
+    ~AnalysisPipeline();
+
+    // 初始化管线；线程数与环容量来自 system.threads / system.queue_size
+    bool init(size_t num_workers, size_t queue_size);
+
+    // 启动分析线程，handler在分析线程上下文中执行
+    bool start(PacketHandler handler);
+
+    // 停止并排空分析线程
+    void stop();
+
+    // 捕获线程调用（线程安全）：按流哈希分派；
+    // 入队失败（环满）时返回false，数据包被丢弃
+    bool submit(capture::PacketInfo packet);
+
+    // 获取各工作队列的统计信息
+    std::vector<QueueStats> getStats() const;
+
+    // 最满工作队列的占用百分比（过载采样的水位信号）
+    size_t maxOccupancyPct() const;
+
+private:
+    struct Worker {
+        std::unique_ptr<MpmcRing<capture::PacketInfo>> ring;
+        std::unique_ptr<std::thread> thread;
+        std::atomic<uint64_t> enqueued{0};
+        std::atomic<uint64_t> dequeued{0};
+        std::atomic<uint64_t> stolen{0};
+    };
+
+    // 计算数据包的流哈希分片号
+    size_t shardOf(const capture::PacketInfo& packet) const;
+
+    // 分析线程主循环（含工作窃取）
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    PacketHandler handler_;
+    std::atomic<bool> running_{false};
+
+    AnalysisPipeline(const AnalysisPipeline&) = delete;
+    AnalysisPipeline& operator=(const AnalysisPipeline&) = delete;
+};
+
+} // namespace pipeline
+} // namespace nips
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "capture/packet_capture.hpp"
+
+namespace nips {
+namespace pipeline {
+
+// 捕获与分析之间的过载控制级：分析队列越过高水位后切入
+// 分层采样——流起始包（TCP SYN）必留，流中段包按步长保留并
+// 打上sample_stride标记（流表据此记录采样率，下游可回算
+// packets_per_second/byte_count），水位回落到低水位后退出。
+// 受控降载取代内核盲丢：长流不会只剩前半截，攻击流量的
+// 流起始信号在最需要的时候仍然完整
+class OverloadSampler {
+public:
+    // 返回分析队列的最高占用百分比；每kCheckInterval个包查询一次
+    using OccupancyFn = std::function<size_t()>;
+
+    // 水位为百分比（高>低构成滞回），stride为采样模式下
+    // 流中段包的保留步长（保留1/stride）
+    bool init(int high_watermark_pct, int low_watermark_pct, int stride,
+              OccupancyFn occupancy);
+
+    // 采样决策（捕获线程调用，线程安全）：返回false表示丢弃。
+    // 保留的流中段包被标记其代表的原始包数
+    bool admit(capture::PacketInfo& packet);
+
+    bool active() const {
+        return sampling_.load(std::memory_order_relaxed);
+    }
+
+    // 累计被采样丢弃的包数（遥测仪表）
+    uint64_t sampledOut() const {
+        return sampled_out_.load(std::memory_order_relaxed);
+    }
+
+private:
+    // 水位查询间隔（按包数，2的幂）
+    static constexpr uint64_t kCheckInterval = 1024;
+
+    // 按当前水位做滞回切换
+    void refresh();
+
+    OccupancyFn occupancy_;
+    std::atomic<uint64_t> counter_{0};
+    std::atomic<uint64_t> sampled_out_{0};
+    std::atomic<bool> sampling_{false};
+    int high_pct_ = 80;
+    int low_pct_ = 60;
+    uint32_t stride_ = 4;
+};
+
+} // namespace pipeline
+} // namespace nips
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "detection/threat_detector.hpp"
+#include "response/response_controller.hpp"
+
+namespace nips {
+namespace response {
+
+// 导出记录类型（ExportRecord::kind）
+constexpr uint8_t kExportThreat = 1;
+constexpr uint8_t kExportAction = 2;
+
+// 共享内存导出记录：定长POD，小端布局固定，备份端
+// （scripts/nips_export.py）按同样的struct格式直接解析。
+// 字符串字段定长截断，无任何序列化/格式化开销
+struct ExportRecord {
+    uint32_t time;             // epoch秒
+    uint8_t kind;              // kExportThreat / kExportAction
+    uint8_t code;              // 威胁等级(ThreatLevel)或动作类型(ActionType)
+    uint8_t success;           // 动作执行结果（威胁记录恒为0）
+    uint8_t pad = 0;
+    uint16_t src_port;         // 动作记录为0
+    uint16_t dst_port;
+    float confidence;          // 动作记录为0
+    char id[16];               // 威胁ID（"THREAT-n"/"CORR-n"）
+    char label[16];            // 威胁类型名（动作记录为空，类型看code）
+    char source[44];           // 威胁源IP / 动作目标
+    char destination[44];      // 威胁目的IP（动作记录为空）
+    char detail[120];          // description / reason（截断）
+};
+
+static_assert(sizeof(ExportRecord) == 256,
+              "ExportRecord布局被改动，需同步scripts/nips_export.py");
+
+// ARIES后端的共享内存导出通道：POSIX共享内存上的广播环，
+// 每槽一个seqlock序号，写入方通过fetch_add认领槽位后无锁发布，
+// 永不等待消费者；消费者落后超过一圈时自行跳到最新位置。
+// 取代逐条JSON写response.log的文本机器通道（告警风暴下的瓶颈）
+class ExportChannel {
+public:
+    ExportChannel();
+    ~ExportChannel();
+
+    // 创建/覆盖共享内存段并初始化环头。capacity向上取2的幂
+    bool init(const std::string& shm_name, size_t capacity);
+
+    // 发布一条威胁记录（任意检测线程可调用，无锁）
+    void publishThreat(const detection::ThreatInfo& threat);
+
+    // 发布一条响应动作记录（响应线程）
+    void publishAction(const ResponseAction& action, bool success);
+
+    // 累计发布的记录数（遥测仪表）
+    uint64_t published() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pimpl_;
+};
+
+} // namespace response
+} // namespace nips
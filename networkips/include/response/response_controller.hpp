@@ -57,6 +57,9 @@ public:
     // 导出响应日志
     bool exportResponseLog(const std::string& file_path);
 
+    // 共享内存通道累计发布的记录数（遥测仪表；通道禁用时为0）
+    uint64_t exportedRecords() const;
+
 private:
     class Impl;
     std::unique_ptr<Impl> pimpl_;
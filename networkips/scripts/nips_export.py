@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""NIPS共享内存导出通道消费端
+
+读取传感器侧ExportChannel（include/response/export_channel.hpp）发布的
+威胁/响应动作记录，供ARIES后端替代对response.log的文本tail：
+64字节段头 + capacity个槽（8字节seqlock序号 + 256字节定长记录）。
+
+广播环语义：写入方永不等待消费者。消费者维护自己的游标；
+落后超过一圈时记录被覆盖，read()自动跳到最旧可读位置并累计
+丢失计数。head回绕到小于游标表示传感器重启，游标随之复位。
+
+用法:
+    reader = ExportReader('/nips_export')
+    for rec in reader.read():       # 返回dict，可反复轮询
+        handle(rec)
+"""
+
+import mmap
+import os
+import struct
+
+MAGIC = b'NIPSEXPT'
+FORMAT_VERSION = 1
+
+HEADER_STRUCT = struct.Struct('<8sIIIIQ32x')  # magic, version, record_size, capacity, pad, head
+SLOT_SEQ_STRUCT = struct.Struct('<Q')
+RECORD_STRUCT = struct.Struct('<IBBBBHHf16s16s44s44s120s')
+
+KIND_THREAT = 1
+KIND_ACTION = 2
+
+THREAT_LEVELS = ['NONE', 'LOW', 'MEDIUM', 'HIGH', 'CRITICAL']
+ACTION_TYPES = ['BLOCK', 'RATE_LIMIT', 'LOG', 'ALERT', 'REDIRECT', 'CUSTOM']
+
+
+def _cstr(raw):
+    return raw.split(b'\0', 1)[0].decode('utf-8', errors='replace')
+
+
+class ExportReader:
+    """共享内存导出环的轮询读取器（单消费者）"""
+
+    def __init__(self, shm_name='/nips_export'):
+        path = os.path.join('/dev/shm', shm_name.lstrip('/'))
+        self._fd = os.open(path, os.O_RDONLY)
+        self._map = mmap.mmap(self._fd, 0, prot=mmap.PROT_READ)
+
+        magic, version, record_size, capacity, _, _ = HEADER_STRUCT.unpack_from(
+            self._map, 0)
+        if magic != MAGIC:
+            raise ValueError(f'{path}: 非NIPS导出段')
+        if version != FORMAT_VERSION:
+            raise ValueError(f'{path}: 不支持的格式版本 {version}')
+        if record_size != RECORD_STRUCT.size:
+            raise ValueError(f'{path}: 记录大小不匹配 '
+                             f'({record_size} != {RECORD_STRUCT.size})')
+
+        self._capacity = capacity
+        self._slot_size = SLOT_SEQ_STRUCT.size + record_size
+        self._cursor = 0          # 下一条待读记录的全局位置
+        self.lost = 0             # 因落后被覆盖而丢失的记录数
+
+    def close(self):
+        self._map.close()
+        os.close(self._fd)
+
+    def _head(self):
+        return HEADER_STRUCT.unpack_from(self._map, 0)[5]
+
+    def _slot_offset(self, pos):
+        return HEADER_STRUCT.size + (pos % self._capacity) * self._slot_size
+
+    def read(self):
+        """产出游标之后所有已发布的记录（非阻塞，读完即返回）"""
+        head = self._head()
+        if head < self._cursor:
+            # head回绕：传感器重启重建了段
+            self._cursor = 0
+        if head - self._cursor > self._capacity:
+            # 落后超过一圈：跳到最旧的仍可读位置
+            self.lost += head - self._capacity - self._cursor
+            self._cursor = head - self._capacity
+
+        while self._cursor < head:
+            pos = self._cursor
+            offset = self._slot_offset(pos)
+            expected = (pos + 1) << 1
+            seq = SLOT_SEQ_STRUCT.unpack_from(self._map, offset)[0]
+            if seq < expected:
+                return  # 槽已认领但尚未发布完成，下次轮询再来
+            if seq > expected:
+                # 读取期间被新一圈覆盖
+                self.lost += 1
+                self._cursor += 1
+                continue
+            raw = bytes(self._map[offset + SLOT_SEQ_STRUCT.size:
+                                  offset + self._slot_size])
+            # 复核序号：拷贝期间未被写入方触碰才算完整
+            if SLOT_SEQ_STRUCT.unpack_from(self._map, offset)[0] != expected:
+                self.lost += 1
+                self._cursor += 1
+                continue
+            self._cursor += 1
+            yield self._decode(raw)
+
+    @staticmethod
+    def _decode(raw):
+        (time_s, kind, code, success, _, src_port, dst_port, confidence,
+         rec_id, label, source, destination, detail) = RECORD_STRUCT.unpack(raw)
+        record = {
+            'time': time_s,
+            'source': _cstr(source),
+            'detail': _cstr(detail),
+        }
+        if kind == KIND_THREAT:
+            record.update({
+                'kind': 'threat',
+                'id': _cstr(rec_id),
+                'type': _cstr(label),
+                'level': THREAT_LEVELS[code] if code < len(THREAT_LEVELS) else str(code),
+                'destination': _cstr(destination),
+                'src_port': src_port,
+                'dst_port': dst_port,
+                'confidence': confidence,
+            })
+        else:
+            record.update({
+                'kind': 'action',
+                'action': ACTION_TYPES[code] if code < len(ACTION_TYPES) else str(code),
+                'success': bool(success),
+            })
+        return record
+
+
+if __name__ == '__main__':
+    import sys
+    import time
+    reader = ExportReader(sys.argv[1] if len(sys.argv) > 1 else '/nips_export')
+    try:
+        while True:
+            for rec in reader.read():
+                print(rec)
+            time.sleep(0.2)
+    except KeyboardInterrupt:
+        pass
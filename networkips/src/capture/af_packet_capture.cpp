@@ -0,0 +1,336 @@
+#include "capture/af_packet_capture.hpp"
+#include "common/config.hpp"
+#include "common/cpu_topology.hpp"
+#include "common/logger.hpp"
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/ip.h>
+#include <arpa/inet.h>
+#include <pcap.h>
+#include <cstring>
+
+namespace nips {
+namespace capture {
+
+namespace {
+// 块大小4MB、帧2KB是TPACKET_V3的常用配置：块足够大摊薄唤醒开销，
+// 块超时保证低流量下的及时交付
+constexpr unsigned int kBlockSize = 1 << 22;
+constexpr unsigned int kBlockCount = 64;
+constexpr unsigned int kFrameSize = 2048;
+constexpr unsigned int kBlockTimeoutMs = 60;
+} // namespace
+
+AFPacketCapture::AFPacketCapture() = default;
+
+AFPacketCapture::~AFPacketCapture() {
+    stop();
+}
+
+bool AFPacketCapture::init(const std::string& interface, const std::string& filter) {
+    auto cfg = common::Config::getInstance().snapshot();
+
+    // 过滤器编译失败即拒绝启动：静默丢掉运维显式配置的排除规则
+    // 比不启动更危险（被排除的流量会灌满管线甚至触发响应）
+    if (!filter.empty() && !compileFilter(filter)) {
+        return false;
+    }
+
+    const int ifindex = if_nametoindex(interface.c_str());
+    if (ifindex == 0) {
+        NIPS_ERROR("无法解析网络接口 {}: {}", interface, strerror(errno));
+        return false;
+    }
+
+    // 分析环两端都是多方安全的，fanout队列数只受网卡RX队列数约束
+    int queues = cfg->capture.fanout_queues;
+    if (queues < 1) queues = 1;
+
+    // fanout组号取进程号低16位，同组socket按流哈希分流
+    fanout_group_ = static_cast<uint16_t>(getpid() & 0xFFFF);
+
+    for (int i = 0; i < queues; ++i) {
+        auto queue = std::make_unique<Queue>();
+        if (!setupQueue(*queue, ifindex)) {
+            queues_.clear();
+            return false;
+        }
+        queues_.push_back(std::move(queue));
+    }
+
+    pool_ = std::make_unique<PacketBufferPool>(
+        cfg->system.queue_size * cfg->system.threads + 1024);
+
+    interface_ = interface;
+    NIPS_INFO("成功初始化AF_PACKET捕获器，接口: {}, fanout队列: {}, 组: {}",
+              interface, queues_.size(), fanout_group_);
+    return true;
+}
+
+bool AFPacketCapture::compileFilter(const std::string& filter) {
+    // 没有live句柄也能编译：pcap_open_dead只为给编译器DLT与快照长度。
+    // classic BPF的sock_filter与libpcap的bpf_insn布局一致，可直接搬运
+    pcap_t* dead = pcap_open_dead(DLT_EN10MB, kFrameSize);
+    if (!dead) {
+        NIPS_ERROR("无法创建BPF编译上下文");
+        return false;
+    }
+    struct bpf_program prog;
+    if (pcap_compile(dead, &prog, filter.c_str(), 1, PCAP_NETMASK_UNKNOWN) != 0) {
+        NIPS_ERROR("无法编译过滤器 \"{}\": {}", filter, pcap_geterr(dead));
+        pcap_close(dead);
+        return false;
+    }
+
+    filter_prog_.resize(prog.bf_len);
+    for (unsigned int i = 0; i < prog.bf_len; ++i) {
+        filter_prog_[i].code = static_cast<uint16_t>(prog.bf_insns[i].code);
+        filter_prog_[i].jt = prog.bf_insns[i].jt;
+        filter_prog_[i].jf = prog.bf_insns[i].jf;
+        filter_prog_[i].k = prog.bf_insns[i].k;
+    }
+    pcap_freecode(&prog);
+    pcap_close(dead);
+    NIPS_INFO("BPF过滤器已编译: \"{}\" ({} 条指令)", filter, filter_prog_.size());
+    return true;
+}
+
+bool AFPacketCapture::setupQueue(Queue& queue, int ifindex) {
+    queue.fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (queue.fd < 0) {
+        NIPS_ERROR("无法创建AF_PACKET socket: {}", strerror(errno));
+        return false;
+    }
+
+    // BPF在建环/绑定之前挂载，不符合过滤器的帧不会进入接收环
+    if (!filter_prog_.empty()) {
+        struct sock_fprog fprog;
+        fprog.len = static_cast<unsigned short>(filter_prog_.size());
+        fprog.filter = filter_prog_.data();
+        if (setsockopt(queue.fd, SOL_SOCKET, SO_ATTACH_FILTER,
+                       &fprog, sizeof(fprog)) < 0) {
+            NIPS_ERROR("无法挂载BPF过滤器: {}", strerror(errno));
+            close(queue.fd);
+            queue.fd = -1;
+            return false;
+        }
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(queue.fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        NIPS_ERROR("无法设置TPACKET_V3: {}", strerror(errno));
+        close(queue.fd);
+        queue.fd = -1;
+        return false;
+    }
+
+    struct tpacket_req3 req;
+    std::memset(&req, 0, sizeof(req));
+    req.tp_block_size = kBlockSize;
+    req.tp_block_nr = kBlockCount;
+    req.tp_frame_size = kFrameSize;
+    req.tp_frame_nr = (kBlockSize / kFrameSize) * kBlockCount;
+    req.tp_retire_blk_tov = kBlockTimeoutMs;
+    req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
+    if (setsockopt(queue.fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        NIPS_ERROR("无法建立PACKET_RX_RING: {}", strerror(errno));
+        close(queue.fd);
+        queue.fd = -1;
+        return false;
+    }
+
+    queue.ring_size = static_cast<size_t>(req.tp_block_size) * req.tp_block_nr;
+    queue.block_count = req.tp_block_nr;
+    queue.ring = static_cast<uint8_t*>(mmap(nullptr, queue.ring_size,
+                                            PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_LOCKED, queue.fd, 0));
+    if (queue.ring == MAP_FAILED) {
+        queue.ring = nullptr;
+        NIPS_ERROR("无法映射接收环: {}", strerror(errno));
+        close(queue.fd);
+        queue.fd = -1;
+        return false;
+    }
+
+    struct sockaddr_ll addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = ifindex;
+    if (bind(queue.fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        NIPS_ERROR("无法绑定接口: {}", strerror(errno));
+        munmap(queue.ring, queue.ring_size);
+        queue.ring = nullptr;
+        close(queue.fd);
+        queue.fd = -1;
+        return false;
+    }
+
+    // 同一fanout组的socket由内核按流哈希分流到各队列线程
+    int fanout = fanout_group_ | (PACKET_FANOUT_HASH << 16);
+    if (setsockopt(queue.fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0) {
+        NIPS_ERROR("无法加入fanout组: {}", strerror(errno));
+        munmap(queue.ring, queue.ring_size);
+        queue.ring = nullptr;
+        close(queue.fd);
+        queue.fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+bool AFPacketCapture::start(PacketCallback callback) {
+    if (queues_.empty() || running_) {
+        return false;
+    }
+
+    running_ = true;
+    callback_ = std::move(callback);
+
+    for (auto& queue : queues_) {
+        queue->thread = std::make_unique<std::thread>(
+            [this, q = queue.get()]() { queueLoop(*q); });
+    }
+
+    NIPS_INFO("AF_PACKET捕获已启动，{} 个队列线程", queues_.size());
+    return true;
+}
+
+void AFPacketCapture::queueLoop(Queue& queue) {
+    // 队列线程绑到网卡所在NUMA节点，池块的first-touch写入随之节点本地化
+    {
+        auto cfg = common::Config::getInstance().snapshot();
+        common::CpuTopology::pinCurrentThread(common::CpuTopology::resolveCpuSet(
+            cfg->system.capture_cpus, interface_));
+    }
+
+    struct pollfd pfd;
+    pfd.fd = queue.fd;
+    pfd.events = POLLIN | POLLERR;
+
+    while (running_) {
+        uint8_t* block = queue.ring +
+            static_cast<size_t>(queue.current_block) * kBlockSize;
+        auto* desc = reinterpret_cast<struct tpacket_block_desc*>(block);
+
+        // 等待内核移交当前块
+        if (!(desc->hdr.bh1.block_status & TP_STATUS_USER)) {
+            poll(&pfd, 1, 100);
+            continue;
+        }
+
+        processBlock(queue, block);
+
+        // 把块还给内核
+        desc->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        queue.current_block = (queue.current_block + 1) % queue.block_count;
+
+        // 读取内核丢包计数（读取即清零，累加保存）
+        struct tpacket_stats_v3 stats;
+        socklen_t len = sizeof(stats);
+        if (getsockopt(queue.fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0) {
+            queue.kernel_drops.fetch_add(stats.tp_drops, std::memory_order_relaxed);
+        }
+    }
+}
+
+void AFPacketCapture::processBlock(Queue& queue, uint8_t* block) {
+    auto* desc = reinterpret_cast<struct tpacket_block_desc*>(block);
+    const uint32_t num_pkts = desc->hdr.bh1.num_pkts;
+
+    auto* hdr = reinterpret_cast<struct tpacket3_hdr*>(
+        block + desc->hdr.bh1.offset_to_first_pkt);
+
+    for (uint32_t i = 0; i < num_pkts; ++i) {
+        const uint8_t* frame = reinterpret_cast<uint8_t*>(hdr) + hdr->tp_mac;
+
+        // 块归还内核后帧内存即失效，而分析是异步的，
+        // 因此这里做一次从映射环到池块的拷贝（仍无堆分配）
+        PacketBuffer buffer = pool_->acquire();
+        if (buffer) {
+            const size_t copy_len = std::min<size_t>(hdr->tp_snaplen,
+                                                     PacketBufferPool::kChunkSize);
+            std::memcpy(buffer.data(), frame, copy_len);
+            buffer.setSize(copy_len);
+
+            PacketInfo info;
+            info.buffer = std::move(buffer);
+            info.timestamp = hdr->tp_sec;
+            info.length = hdr->tp_len;
+            info.interface = &interface_;
+
+            // 头部解析一次，下游各级只读parsed字段
+            parsePacket(info);
+
+            queue.packets.fetch_add(1, std::memory_order_relaxed);
+            if (callback_) {
+                callback_(std::move(info));
+            }
+        }
+
+        hdr = reinterpret_cast<struct tpacket3_hdr*>(
+            reinterpret_cast<uint8_t*>(hdr) + hdr->tp_next_offset);
+    }
+}
+
+void AFPacketCapture::stop() {
+    running_ = false;
+    for (auto& queue : queues_) {
+        if (queue->thread && queue->thread->joinable()) {
+            queue->thread->join();
+        }
+        queue->thread.reset();
+        if (queue->ring) {
+            munmap(queue->ring, queue->ring_size);
+            queue->ring = nullptr;
+        }
+        if (queue->fd >= 0) {
+            close(queue->fd);
+            queue->fd = -1;
+        }
+    }
+    queues_.clear();
+    callback_ = nullptr;
+}
+
+uint64_t AFPacketCapture::kernelDrops() const {
+    uint64_t total = 0;
+    for (const auto& queue : queues_) {
+        total += queue->kernel_drops.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::vector<AFPacketCapture::QueueStats> AFPacketCapture::getQueueStats() const {
+    std::vector<QueueStats> stats;
+    stats.reserve(queues_.size());
+    for (const auto& queue : queues_) {
+        stats.push_back(QueueStats{
+            queue->packets.load(std::memory_order_relaxed),
+            queue->kernel_drops.load(std::memory_order_relaxed)
+        });
+    }
+    return stats;
+}
+
+// 工厂：根据 capture.backend 选择捕获后端
+std::unique_ptr<CaptureSource> createCaptureSource() {
+    auto backend = common::Config::getInstance().snapshot()->capture.backend;
+    if (backend == "af_packet") {
+        return std::make_unique<AFPacketCapture>();
+    }
+    if (backend != "pcap") {
+        NIPS_WARN("未知的捕获后端 '{}'，回退到pcap", backend);
+    }
+    return std::make_unique<PacketCapture>();
+}
+
+} // namespace capture
+} // namespace nips
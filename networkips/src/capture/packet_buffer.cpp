@@ -0,0 +1,51 @@
+#include "capture/packet_buffer.hpp"
+
+namespace nips {
+namespace capture {
+
+PacketBufferPool::PacketBufferPool(size_t chunk_count)
+    : storage_(new uint8_t[chunk_count * kChunkSize]),
+      next_(chunk_count) {
+    // 把所有块串成空闲链
+    for (size_t i = 0; i < chunk_count; ++i) {
+        next_[i].store(i + 1 < chunk_count ? static_cast<uint32_t>(i + 1)
+                                           : PacketBuffer::kInvalid,
+                       std::memory_order_relaxed);
+    }
+    head_.store(makeHead(chunk_count > 0 ? 0 : PacketBuffer::kInvalid, 0),
+                std::memory_order_relaxed);
+}
+
+PacketBuffer PacketBufferPool::acquire() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    for (;;) {
+        const uint32_t index = static_cast<uint32_t>(head);
+        if (index == PacketBuffer::kInvalid) {
+            exhausted_.fetch_add(1, std::memory_order_relaxed);
+            return PacketBuffer();
+        }
+        const uint32_t tag = static_cast<uint32_t>(head >> 32);
+        const uint32_t next = next_[index].load(std::memory_order_relaxed);
+        if (head_.compare_exchange_weak(head, makeHead(next, tag + 1),
+                                        std::memory_order_acquire,
+                                        std::memory_order_acquire)) {
+            return PacketBuffer(this, index);
+        }
+    }
+}
+
+void PacketBufferPool::release(uint32_t index) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    for (;;) {
+        const uint32_t tag = static_cast<uint32_t>(head >> 32);
+        next_[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        if (head_.compare_exchange_weak(head, makeHead(index, tag + 1),
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+} // namespace capture
+} // namespace nips
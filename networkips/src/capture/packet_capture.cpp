@@ -1,230 +1,265 @@
 #include "capture/packet_capture.hpp"
+#include "common/config.hpp"
+#include "common/cpu_topology.hpp"
 #include "common/logger.hpp"
 #include <pcap.h>
 #include <netinet/ip.h>
 #include <netinet/tcp.h>
 #include <netinet/udp.h>
 #include <arpa/inet.h>
+#include <cstring>
 #include <chrono>
-#include <thread>
-#include <mutex>
 
 namespace nips {
 namespace capture {
 
-class PacketCapture {
-private:
-    pcap_t* handle_;
-    bool running_;
-    std::string interface_;
-    std::string filter_;
-    std::unique_ptr<std::thread> capture_thread_;
-    PacketCallback callback_;
-    std::mutex callback_mutex_;  // 保护callback_的互斥锁
-    
-    // RAII包装器类
-    class PcapHandleGuard {
-    public:
-        explicit PcapHandleGuard(pcap_t* handle) : handle_(handle) {}
-        ~PcapHandleGuard() {
-            if (handle_) {
-                pcap_close(handle_);
-            }
-        }
-        pcap_t* get() const { return handle_; }
-        pcap_t* release() {
-            pcap_t* temp = handle_;
-            handle_ = nullptr;
-            return temp;
-        }
-    private:
-        pcap_t* handle_;
-        PcapHandleGuard(const PcapHandleGuard&) = delete;
-        PcapHandleGuard& operator=(const PcapHandleGuard&) = delete;
-    };
-    
-    class BpfProgramGuard {
-    public:
-        explicit BpfProgramGuard(pcap_t* handle) : handle_(handle), fp_(nullptr) {}
-        ~BpfProgramGuard() {
-            if (fp_) {
-                pcap_freecode(fp_);
-            }
-        }
-        bpf_program* get() { return &fp_; }
-        bool compile(const std::string& filter) {
-            return pcap_compile(handle_, &fp_, filter.c_str(), 0, PCAP_NETMASK_UNKNOWN) == 0;
-        }
-    private:
-        pcap_t* handle_;
-        bpf_program fp_;
-        BpfProgramGuard(const BpfProgramGuard&) = delete;
-        BpfProgramGuard& operator=(const BpfProgramGuard&) = delete;
-    };
+namespace {
 
+// RAII包装器：init失败路径上自动关闭pcap句柄
+class PcapHandleGuard {
 public:
-    PacketCapture() : handle_(nullptr), running_(false) {}
-    
-    ~PacketCapture() {
-        stop();
-    }
-    
-    bool init(const std::string& interface, const std::string& filter = "") {
-        char errbuf[PCAP_ERRBUF_SIZE];
-        
-        try {
-            // 使用RAII包装器管理pcap句柄
-            PcapHandleGuard handle_guard(pcap_open_live(
-                interface.c_str(),
-                common::Config::getInstance().get<int>("capture.buffer_size"),
-                common::Config::getInstance().get<bool>("capture.promiscuous"),
-                common::Config::getInstance().get<int>("capture.timeout_ms"),
-                errbuf
-            ));
-            
-            if (!handle_guard.get()) {
-                NIPS_ERROR("无法打开网络接口 {}: {}", interface, errbuf);
-                return false;
-            }
-            
-            // 设置过滤器
-            if (!filter.empty()) {
-                BpfProgramGuard bpf_guard(handle_guard.get());
-                if (!bpf_guard.compile(filter)) {
-                    NIPS_ERROR("无法编译过滤器: {}", pcap_geterr(handle_guard.get()));
-                    return false;
-                }
-                
-                if (pcap_setfilter(handle_guard.get(), bpf_guard.get()) == -1) {
-                    NIPS_ERROR("无法设置过滤器: {}", pcap_geterr(handle_guard.get()));
-                    return false;
-                }
-            }
-            
-            // 转移所有权
-            handle_ = handle_guard.release();
-            interface_ = interface;
-            filter_ = filter;
-            
-            NIPS_INFO("成功初始化数据包捕获器，接口: {}", interface);
-            return true;
-            
-        } catch (const std::exception& e) {
-            NIPS_ERROR("初始化数据包捕获器时发生异常: {}", e.what());
-            return false;
-        }
-    }
-    
-    void stop() {
-        running_ = false;
-        if (capture_thread_ && capture_thread_->joinable()) {
-            capture_thread_->join();
-        }
-        {
-            std::lock_guard<std::mutex> lock(callback_mutex_);
-            callback_ = nullptr;
-        }
+    explicit PcapHandleGuard(pcap_t* handle) : handle_(handle) {}
+    ~PcapHandleGuard() {
         if (handle_) {
             pcap_close(handle_);
-            handle_ = nullptr;
         }
     }
+    pcap_t* get() const { return handle_; }
+    pcap_t* release() {
+        pcap_t* temp = handle_;
+        handle_ = nullptr;
+        return temp;
+    }
+private:
+    pcap_t* handle_;
+    PcapHandleGuard(const PcapHandleGuard&) = delete;
+    PcapHandleGuard& operator=(const PcapHandleGuard&) = delete;
+};
 
-    bool start(PacketCallback callback) {
-        if (!handle_ || running_) {
-            return false;
+class BpfProgramGuard {
+public:
+    explicit BpfProgramGuard(pcap_t* handle) : handle_(handle), compiled_(false) {}
+    ~BpfProgramGuard() {
+        if (compiled_) {
+            pcap_freecode(&fp_);
         }
+    }
+    bpf_program* get() { return &fp_; }
+    bool compile(const std::string& filter) {
+        compiled_ = pcap_compile(handle_, &fp_, filter.c_str(), 0, PCAP_NETMASK_UNKNOWN) == 0;
+        return compiled_;
+    }
+private:
+    pcap_t* handle_;
+    bpf_program fp_;
+    bool compiled_;
+    BpfProgramGuard(const BpfProgramGuard&) = delete;
+    BpfProgramGuard& operator=(const BpfProgramGuard&) = delete;
+};
 
-        running_ = true;
-        {
-            std::lock_guard<std::mutex> lock(callback_mutex_);
-            callback_ = std::move(callback);
-        }
+} // namespace
 
-        // 启动捕获线程
-        capture_thread_ = std::thread([this]() {
-            while (running_) {
-                struct pcap_pkthdr* header;
-                const u_char* packet;
-                int result = pcap_next_ex(handle_, &header, &packet);
-                
-                if (result == 1) {  // 成功捕获数据包
-                    PacketInfo info;
-                    info.timestamp = header->ts.tv_sec;
-                    info.length = header->len;
-                    info.interface = interface_;
-                    
-                    // 复制数据包内容
-                    info.data.assign(packet, packet + header->len);
-                    
-                    // 解析数据包方向
-                    struct ip* ip_header = (struct ip*)(packet + 14);  // 跳过以太网头
-                    if (ip_header->ip_v == 4) {
-                        // 根据源IP判断方向
-                        char src_ip[INET_ADDRSTRLEN];
-                        inet_ntop(AF_INET, &(ip_header->ip_src), src_ip, INET_ADDRSTRLEN);
-                        info.is_outbound = (std::string(src_ip) == interface_);
-                    }
-                    
-                    // 调用回调函数
-                    std::lock_guard<std::mutex> lock(callback_mutex_);
-                    if (callback_) {
-                        callback_(info);
-                    }
-                } else if (result == -1) {  // 错误
-                    NIPS_ERROR("数据包捕获错误: {}", pcap_geterr(handle_));
-                    break;
-                }
-            }
-        });
+PacketCapture::PacketCapture() : handle_(nullptr), running_(false) {}
 
-        NIPS_INFO("数据包捕获已启动");
-        return true;
-    }
+PacketCapture::~PacketCapture() {
+    stop();
+}
+
+bool PacketCapture::init(const std::string& interface, const std::string& filter) {
+    char errbuf[PCAP_ERRBUF_SIZE];
+
+    try {
+        auto cfg = common::Config::getInstance().snapshot();
 
-    bool setFilter(const std::string& filter) {
-        if (!handle_) {
+        PcapHandleGuard handle_guard(pcap_open_live(
+            interface.c_str(),
+            cfg->capture.buffer_size,
+            cfg->capture.promiscuous,
+            cfg->capture.timeout_ms,
+            errbuf
+        ));
+
+        if (!handle_guard.get()) {
+            NIPS_ERROR("无法打开网络接口 {}: {}", interface, errbuf);
             return false;
         }
 
-        struct bpf_program fp;
-        if (pcap_compile(handle_, &fp, filter.c_str(), 0, PCAP_NETMASK_UNKNOWN) == -1) {
-            NIPS_ERROR("无法编译过滤器: {}", pcap_geterr(handle_));
-            return false;
+        // 设置过滤器
+        if (!filter.empty()) {
+            BpfProgramGuard bpf_guard(handle_guard.get());
+            if (!bpf_guard.compile(filter)) {
+                NIPS_ERROR("无法编译过滤器: {}", pcap_geterr(handle_guard.get()));
+                return false;
+            }
+
+            if (pcap_setfilter(handle_guard.get(), bpf_guard.get()) == -1) {
+                NIPS_ERROR("无法设置过滤器: {}", pcap_geterr(handle_guard.get()));
+                return false;
+            }
         }
 
-        if (pcap_setfilter(handle_, &fp) == -1) {
-            NIPS_ERROR("无法设置过滤器: {}", pcap_geterr(handle_));
-            pcap_freecode(&fp);
+        // DLT在会话内不变：解码器在此一次性选定为模板实例化，
+        // 热路径上不再有链路层类型判断
+        const int dlt = pcap_datalink(handle_guard.get());
+        parser_ = parserForDatalink(dlt);
+        if (!parser_) {
+            NIPS_ERROR("不支持的链路层类型 DLT={}，接口: {}", dlt, interface);
             return false;
         }
 
-        pcap_freecode(&fp);
+        // 缓冲池按全部分析队列的总深度加余量预分配，
+        // 保证所有队列打满时捕获线程仍有块可用
+        pool_ = std::make_unique<PacketBufferPool>(
+            cfg->system.queue_size * cfg->system.threads + 1024);
+
+        // 转移所有权
+        handle_ = handle_guard.release();
+        interface_ = interface;
         filter_ = filter;
-        NIPS_INFO("成功设置过滤器: {}", filter);
+
+        NIPS_INFO("成功初始化数据包捕获器，接口: {}, 缓冲池: {} x {} 字节",
+                  interface, pool_->chunkCount(), PacketBufferPool::kChunkSize);
         return true;
+
+    } catch (const std::exception& e) {
+        NIPS_ERROR("初始化数据包捕获器时发生异常: {}", e.what());
+        return false;
     }
+}
 
-    std::vector<std::string> getAvailableInterfaces() {
-        std::vector<std::string> interfaces;
-        char errbuf[PCAP_ERRBUF_SIZE];
-        pcap_if_t* alldevs;
-        
-        if (pcap_findalldevs(&alldevs, errbuf) == -1) {
-            NIPS_ERROR("无法获取网络接口列表: {}", errbuf);
-            return interfaces;
-        }
+bool PacketCapture::start(PacketCallback callback) {
+    if (!handle_ || running_) {
+        return false;
+    }
+
+    running_ = true;
+    callback_ = std::move(callback);
+    capture_thread_ = std::make_unique<std::thread>([this]() { captureLoop(); });
+
+    NIPS_INFO("数据包捕获已启动");
+    return true;
+}
+
+void PacketCapture::captureLoop() {
+    // 绑到网卡所在NUMA节点的CPU；池块的首次写入也发生在本线程，
+    // 包缓冲页随之first-touch落在同节点
+    {
+        auto cfg = common::Config::getInstance().snapshot();
+        common::CpuTopology::pinCurrentThread(common::CpuTopology::resolveCpuSet(
+            cfg->system.capture_cpus, interface_));
+    }
 
-        for (pcap_if_t* dev = alldevs; dev != nullptr; dev = dev->next) {
-            if (dev->name) {
-                interfaces.push_back(dev->name);
+    while (running_) {
+        struct pcap_pkthdr* header;
+        const u_char* packet;
+        int result = pcap_next_ex(handle_, &header, &packet);
+
+        if (result == 1) {  // 成功捕获数据包
+            // 从池中取块；池耗尽时丢包，不回退到堆分配
+            PacketBuffer buffer = pool_->acquire();
+            if (!buffer) {
+                continue;
+            }
+
+            const size_t copy_len = std::min<size_t>(header->caplen,
+                                                     PacketBufferPool::kChunkSize);
+            std::memcpy(buffer.data(), packet, copy_len);
+            buffer.setSize(copy_len);
+
+            PacketInfo info;
+            info.buffer = std::move(buffer);
+            info.timestamp = header->ts.tv_sec;
+            info.length = header->len;
+            info.interface = &interface_;  // 接口名只驻留一份，每包仅携带指针
+
+            // 头部解析一次（会话DLT对应的实例化），下游各级只读parsed字段
+            parser_(info);
+
+            // 解析数据包方向
+            if (info.parsed.valid && info.parsed.ip_version == 4) {
+                char src_ip[INET_ADDRSTRLEN];
+                const struct in_addr src_addr = {htonl(info.parsed.src_ip)};
+                inet_ntop(AF_INET, &src_addr, src_ip, INET_ADDRSTRLEN);
+                info.is_outbound = (std::strcmp(src_ip, interface_.c_str()) == 0);
+            }
+
+            // 调用回调函数，转移报文所有权
+            if (callback_) {
+                callback_(std::move(info));
             }
+        } else if (result == -1) {  // 错误
+            NIPS_ERROR("数据包捕获错误: {}", pcap_geterr(handle_));
+            break;
         }
+    }
+}
 
-        pcap_freealldevs(alldevs);
+void PacketCapture::stop() {
+    running_ = false;
+    if (capture_thread_ && capture_thread_->joinable()) {
+        capture_thread_->join();
+    }
+    capture_thread_.reset();
+    callback_ = nullptr;
+    if (handle_) {
+        pcap_close(handle_);
+        handle_ = nullptr;
+    }
+}
+
+bool PacketCapture::setFilter(const std::string& filter) {
+    if (!handle_) {
+        return false;
+    }
+
+    struct bpf_program fp;
+    if (pcap_compile(handle_, &fp, filter.c_str(), 0, PCAP_NETMASK_UNKNOWN) == -1) {
+        NIPS_ERROR("无法编译过滤器: {}", pcap_geterr(handle_));
+        return false;
+    }
+
+    if (pcap_setfilter(handle_, &fp) == -1) {
+        NIPS_ERROR("无法设置过滤器: {}", pcap_geterr(handle_));
+        pcap_freecode(&fp);
+        return false;
+    }
+
+    pcap_freecode(&fp);
+    filter_ = filter;
+    NIPS_INFO("成功设置过滤器: {}", filter);
+    return true;
+}
+
+uint64_t PacketCapture::kernelDrops() const {
+    if (!handle_) {
+        return 0;
+    }
+    struct pcap_stat stats;
+    if (pcap_stats(handle_, &stats) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(stats.ps_drop) + stats.ps_ifdrop;
+}
+
+std::vector<std::string> PacketCapture::getAvailableInterfaces() {
+    std::vector<std::string> interfaces;
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_if_t* alldevs;
+
+    if (pcap_findalldevs(&alldevs, errbuf) == -1) {
+        NIPS_ERROR("无法获取网络接口列表: {}", errbuf);
         return interfaces;
     }
-};
+
+    for (pcap_if_t* dev = alldevs; dev != nullptr; dev = dev->next) {
+        if (dev->name) {
+            interfaces.push_back(dev->name);
+        }
+    }
+
+    pcap_freealldevs(alldevs);
+    return interfaces;
+}
 
 } // namespace capture
-} // namespace nips 
\ No newline at end of file
+} // namespace nips
@@ -0,0 +1,214 @@
+#include "capture/packet_parser.hpp"
+#include "capture/packet_capture.hpp"
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+
+namespace nips {
+namespace capture {
+
+namespace {
+
+// pcap的DLT值（本地定义，解析器不依赖pcap.h——AF_PACKET路径也走这里）
+constexpr int kDltEn10Mb = 1;     // DLT_EN10MB
+constexpr int kDltRaw = 12;       // DLT_RAW（Linux取值）
+constexpr int kDltLinuxSll = 113; // DLT_LINUX_SLL
+
+// 扩展头链的遍历上限：防御构造的超长链
+constexpr int kMaxIpv6ExtHeaders = 8;
+
+uint16_t readBe16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+// 128位地址折叠为32位：四个字XOR。仅用于流键与关联计数，
+// 碰撞只会把两条流并入同一特征聚合，可容忍
+uint32_t foldIpv6(const struct in6_addr& addr) {
+    uint32_t fold = 0;
+    for (int i = 0; i < 16; i += 4) {
+        fold ^= static_cast<uint32_t>(addr.s6_addr[i]) << 24 |
+                static_cast<uint32_t>(addr.s6_addr[i + 1]) << 16 |
+                static_cast<uint32_t>(addr.s6_addr[i + 2]) << 8 |
+                addr.s6_addr[i + 3];
+    }
+    return fold;
+}
+
+// IPv4头：返回false表示头部越界（parsed.valid保持false）
+bool parseIpv4(const uint8_t* data, size_t size, size_t& offset,
+               ParsedPacket& parsed) {
+    if (offset + sizeof(struct ip) > size) {
+        return false;
+    }
+    const struct ip* ip_header = (const struct ip*)(data + offset);
+    if (ip_header->ip_v != 4) {
+        return false;
+    }
+    const size_t ihl = static_cast<size_t>(ip_header->ip_hl) << 2;
+    if (ihl < sizeof(struct ip) || offset + ihl > size) {
+        return false;
+    }
+    parsed.ip_version = 4;
+    parsed.protocol = ip_header->ip_p;
+    parsed.src_ip = ntohl(ip_header->ip_src.s_addr);
+    parsed.dst_ip = ntohl(ip_header->ip_dst.s_addr);
+    offset += ihl;
+    return true;
+}
+
+// IPv6头：固定头之后展开扩展头链直到上层协议。
+// 扩展头统一布局为(next, hdrlen)前导，长度单位因类型而异
+bool parseIpv6(const uint8_t* data, size_t size, size_t& offset,
+               ParsedPacket& parsed) {
+    if (offset + sizeof(struct ip6_hdr) > size) {
+        return false;
+    }
+    const struct ip6_hdr* ip6_header = (const struct ip6_hdr*)(data + offset);
+    parsed.ip_version = 6;
+    parsed.src_ip = foldIpv6(ip6_header->ip6_src);
+    parsed.dst_ip = foldIpv6(ip6_header->ip6_dst);
+    offset += sizeof(struct ip6_hdr);
+
+    uint8_t next = ip6_header->ip6_nxt;
+    for (int depth = 0; depth < kMaxIpv6ExtHeaders; ++depth) {
+        size_t ext_len;
+        switch (next) {
+            case IPPROTO_HOPOPTS:
+            case IPPROTO_ROUTING:
+            case IPPROTO_DSTOPTS:
+                if (offset + 8 > size) return false;
+                ext_len = (static_cast<size_t>(data[offset + 1]) + 1) << 3;
+                break;
+            case IPPROTO_FRAGMENT:
+                // 分片头固定8字节；非首分片无L4头，端口解析自然落空
+                if (offset + 8 > size) return false;
+                ext_len = 8;
+                break;
+            case IPPROTO_AH:
+                // AH的长度单位是4字节且基数为2
+                if (offset + 8 > size) return false;
+                ext_len = (static_cast<size_t>(data[offset + 1]) + 2) << 2;
+                break;
+            default:
+                // 到达上层协议（TCP/UDP/ICMPv6/...）
+                parsed.protocol = next;
+                return true;
+        }
+        if (offset + ext_len > size) {
+            return false;
+        }
+        next = data[offset];
+        offset += ext_len;
+    }
+    return false;  // 链超长，按解析失败处理
+}
+
+// L4头：TCP/UDP提取端口与标志，其余协议只定位负载
+void parseL4(const uint8_t* data, size_t size, size_t offset,
+             ParsedPacket& parsed) {
+    if (parsed.protocol == IPPROTO_TCP && offset + sizeof(struct tcphdr) <= size) {
+        const struct tcphdr* tcp_header = (const struct tcphdr*)(data + offset);
+        parsed.src_port = ntohs(tcp_header->source);
+        parsed.dst_port = ntohs(tcp_header->dest);
+        parsed.tcp_flags = static_cast<uint8_t>(
+            (tcp_header->fin ? kTcpFin : 0) | (tcp_header->syn ? kTcpSyn : 0) |
+            (tcp_header->rst ? kTcpRst : 0) | (tcp_header->psh ? kTcpPsh : 0) |
+            (tcp_header->ack ? kTcpAck : 0) | (tcp_header->urg ? kTcpUrg : 0));
+        const size_t doff = static_cast<size_t>(tcp_header->doff) << 2;
+        // 数据偏移异常时按无负载处理，5元组仍然有效
+        offset = (doff >= sizeof(struct tcphdr) && offset + doff <= size) ?
+                 offset + doff : size;
+    } else if (parsed.protocol == IPPROTO_UDP &&
+               offset + sizeof(struct udphdr) <= size) {
+        const struct udphdr* udp_header = (const struct udphdr*)(data + offset);
+        parsed.src_port = ntohs(udp_header->source);
+        parsed.dst_port = ntohs(udp_header->dest);
+        offset += sizeof(struct udphdr);
+    } else if (parsed.protocol == IPPROTO_TCP || parsed.protocol == IPPROTO_UDP) {
+        // L4头被截断：保留L3信息但无端口/负载
+        offset = size;
+    }
+
+    parsed.payload_offset = static_cast<uint16_t>(offset);
+    parsed.payload_length = static_cast<uint16_t>(size - offset);
+    parsed.valid = true;
+}
+
+} // namespace
+
+template <LinkLayer Link>
+void parseFrame(PacketInfo& info) {
+    ParsedPacket& parsed = info.parsed;
+    parsed = ParsedPacket{};
+
+    const uint8_t* data = info.data();
+    const size_t size = info.size();
+    if (!data || size == 0) {
+        return;
+    }
+
+    // 链路层：Link是模板参数，分支在编译期折叠
+    size_t offset = 0;
+    bool is_v4;
+    if constexpr (Link == LinkLayer::kRawIp) {
+        is_v4 = (data[0] >> 4) == 4;
+    } else {
+        uint16_t ethertype;
+        if constexpr (Link == LinkLayer::kEthernet) {
+            // 以太网头：EtherType在12字节处，VLAN标签各占4字节且可叠加
+            if (size < 14) {
+                return;
+            }
+            offset = 12;
+            ethertype = readBe16(data + offset);
+            offset += 2;
+            while ((ethertype == 0x8100 || ethertype == 0x88A8) &&
+                   offset + 4 <= size) {
+                ethertype = readBe16(data + offset + 2);
+                offset += 4;
+            }
+        } else {  // LinkLayer::kLinuxSll
+            // cooked头固定16字节，协议字段在14字节处（网络字节序）
+            if (size < 16) {
+                return;
+            }
+            ethertype = readBe16(data + 14);
+            offset = 16;
+        }
+        if (ethertype == 0x0800) {
+            is_v4 = true;
+        } else if (ethertype == 0x86DD) {
+            is_v4 = false;
+        } else {
+            return;
+        }
+    }
+
+    if (is_v4 ? !parseIpv4(data, size, offset, parsed)
+              : !parseIpv6(data, size, offset, parsed)) {
+        return;
+    }
+    parseL4(data, size, offset, parsed);
+}
+
+template void parseFrame<LinkLayer::kEthernet>(PacketInfo& info);
+template void parseFrame<LinkLayer::kLinuxSll>(PacketInfo& info);
+template void parseFrame<LinkLayer::kRawIp>(PacketInfo& info);
+
+ParseFn parserForDatalink(int dlt) {
+    switch (dlt) {
+        case kDltEn10Mb:   return &parseFrame<LinkLayer::kEthernet>;
+        case kDltLinuxSll: return &parseFrame<LinkLayer::kLinuxSll>;
+        case kDltRaw:      return &parseFrame<LinkLayer::kRawIp>;
+        default:           return nullptr;
+    }
+}
+
+void parsePacket(PacketInfo& info) {
+    parseFrame<LinkLayer::kEthernet>(info);
+}
+
+} // namespace capture
+} // namespace nips
@@ -0,0 +1,167 @@
+#include "common/config.hpp"
+#include "common/logger.hpp"
+#include <fstream>
+
+namespace nips {
+namespace common {
+
+namespace {
+
+// 带默认值的标量读取
+template<typename T>
+T node(const YAML::Node& parent, const char* key, const T& default_value) {
+    try {
+        if (parent && parent[key]) {
+            return parent[key].as<T>();
+        }
+    } catch (const std::exception&) {
+    }
+    return default_value;
+}
+
+} // namespace
+
+Config& Config::getInstance() {
+    static Config instance;
+    return instance;
+}
+
+bool Config::load(const std::string& config_path) {
+    try {
+        config_ = YAML::LoadFile(config_path);
+        current_config_path_ = config_path;
+        std::atomic_store_explicit(&snapshot_, buildSnapshot(),
+                                   std::memory_order_release);
+        return true;
+    } catch (const std::exception& e) {
+        NIPS_ERROR("无法加载配置文件 {}: {}", config_path, e.what());
+        return false;
+    }
+}
+
+bool Config::reload() {
+    if (current_config_path_.empty()) {
+        return false;
+    }
+    return load(current_config_path_);
+}
+
+std::shared_ptr<const ConfigSnapshot> Config::buildSnapshot() const {
+    auto snapshot = std::make_shared<ConfigSnapshot>();
+
+    const auto capture = config_["capture"];
+    snapshot->capture.interface = node<std::string>(capture, "interface", "eth0");
+    snapshot->capture.backend = node<std::string>(capture, "backend", "pcap");
+    snapshot->capture.filter = node<std::string>(capture, "filter", "");
+    snapshot->capture.buffer_size = node<int>(capture, "buffer_size", 65535);
+    snapshot->capture.timeout_ms = node<int>(capture, "timeout_ms", 1000);
+    snapshot->capture.promiscuous = node<bool>(capture, "promiscuous", true);
+    snapshot->capture.fanout_queues = node<int>(capture, "fanout_queues", 4);
+
+    const auto feature = config_["feature"];
+    snapshot->feature.flow_timeout_seconds = node<size_t>(feature, "flow_timeout_seconds", 300);
+    snapshot->feature.max_packets_per_flow = node<size_t>(feature, "max_packets_per_flow", 1000);
+    snapshot->feature.enable_deep_packet_inspection =
+        node<bool>(feature, "enable_deep_packet_inspection", true);
+    if (feature && feature["enabled_features"]) {
+        for (const auto& item : feature["enabled_features"]) {
+            snapshot->feature.enabled_features.push_back(item.as<std::string>());
+        }
+    }
+    snapshot->feature.export_dir = node<std::string>(feature, "export_dir", "");
+    snapshot->feature.export_segment_mb = node<size_t>(feature, "export_segment_mb", 64);
+
+    const auto ml = config_["ml"];
+    snapshot->ml.model_type = node<std::string>(ml, "model_type", "deep_learning");
+    snapshot->ml.model_path = node<std::string>(ml, "model_path", "");
+    snapshot->ml.anomaly_threshold = node<float>(ml, "anomaly_threshold", 0.85f);
+    snapshot->ml.batch_size = node<size_t>(ml, "batch_size", 64);
+    snapshot->ml.max_batch_delay_ms = node<size_t>(ml, "max_batch_delay_ms", 20);
+    snapshot->ml.enable_gpu = node<bool>(ml, "enable_gpu", false);
+    snapshot->ml.enable_verdict_cache = node<bool>(ml, "enable_verdict_cache", true);
+    snapshot->ml.verdict_clean_batches = node<size_t>(ml, "verdict_clean_batches", 3);
+    snapshot->ml.verdict_score_margin = node<float>(ml, "verdict_score_margin", 0.2f);
+    snapshot->ml.verdict_resample_interval = node<size_t>(ml, "verdict_resample_interval", 16);
+    snapshot->ml.verdict_max_entries = node<size_t>(ml, "verdict_max_entries", 100000);
+
+    const auto detection = config_["detection"];
+    snapshot->detection.intel_source = node<std::string>(detection, "intel_source", "");
+    snapshot->detection.max_threats_history = node<size_t>(detection, "max_threats_history", 1000);
+    snapshot->detection.enable_correlation = node<bool>(detection, "enable_correlation", false);
+    snapshot->detection.correlation_window_seconds =
+        node<size_t>(detection, "correlation_window_seconds", 60);
+    snapshot->detection.correlation_port_threshold =
+        node<size_t>(detection, "correlation_port_threshold", 20);
+    snapshot->detection.correlation_host_threshold =
+        node<size_t>(detection, "correlation_host_threshold", 20);
+    if (detection && detection["threat_thresholds"]) {
+        for (const auto& item : detection["threat_thresholds"]) {
+            snapshot->detection.threat_thresholds[item.first.as<std::string>()] =
+                item.second.as<float>();
+        }
+    }
+
+    const auto response = config_["response"];
+    snapshot->response.policy_path = node<std::string>(response, "policy_path", "");
+    snapshot->response.enable_auto_response = node<bool>(response, "enable_auto_response", true);
+    snapshot->response.max_concurrent_actions =
+        node<size_t>(response, "max_concurrent_actions", 100);
+    snapshot->response.log_path =
+        node<std::string>(response, "log_path", "/var/log/nips/response.log");
+    snapshot->response.export_shm =
+        node<std::string>(response, "export_shm", "/nips_export");
+    snapshot->response.export_capacity = node<size_t>(response, "export_capacity", 4096);
+
+    const auto system = config_["system"];
+    snapshot->system.threads = node<int>(system, "threads", 4);
+    snapshot->system.queue_size = node<size_t>(system, "queue_size", 10000);
+    snapshot->system.memory_limit = node<size_t>(system, "memory_limit", 1073741824);
+    snapshot->system.check_interval = node<int>(system, "check_interval", 60);
+    snapshot->system.metrics_port = node<int>(system, "metrics_port", 9105);
+    snapshot->system.overload_high_pct = node<int>(system, "overload_high_pct", 80);
+    snapshot->system.overload_low_pct = node<int>(system, "overload_low_pct", 60);
+    snapshot->system.overload_sample_stride = node<int>(system, "overload_sample_stride", 4);
+    snapshot->system.capture_cpus = node<std::string>(system, "capture_cpus", "");
+    snapshot->system.analysis_cpus = node<std::string>(system, "analysis_cpus", "");
+    snapshot->system.torch_threads = node<int>(system, "torch_threads", 0);
+
+    return snapshot;
+}
+
+void Config::setNode(const std::vector<std::string>& segments, YAML::Node value) {
+    // 逐段下钻；yaml-cpp的Node是共享引用语义，对中间节点的
+    // 赋值会反映到config_
+    YAML::Node current = config_;
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        YAML::Node next = current[segments[i]];
+        if (!next.IsDefined() || !next.IsMap()) {
+            current[segments[i]] = YAML::Node(YAML::NodeType::Map);
+            next = current[segments[i]];
+        }
+        current = next;
+    }
+    current[segments.back()] = value;
+    std::atomic_store_explicit(&snapshot_, buildSnapshot(),
+                               std::memory_order_release);
+}
+
+bool Config::save(const std::string& config_path) {
+    const std::string& path = config_path.empty() ? current_config_path_ : config_path;
+    if (path.empty()) {
+        return false;
+    }
+    try {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << YAML::Dump(config_);
+        return true;
+    } catch (const std::exception& e) {
+        NIPS_ERROR("无法保存配置文件 {}: {}", path, e.what());
+        return false;
+    }
+}
+
+} // namespace common
+} // namespace nips
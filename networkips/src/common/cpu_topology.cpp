@@ -0,0 +1,107 @@
+#include "common/cpu_topology.hpp"
+#include "common/logger.hpp"
+#include <fstream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+
+namespace nips {
+namespace common {
+
+namespace {
+
+// 读取sysfs单值文件；失败返回空串
+std::string readSysfs(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return "";
+    }
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+} // namespace
+
+int CpuTopology::nicNumaNode(const std::string& interface) {
+    const std::string value =
+        readSysfs("/sys/class/net/" + interface + "/device/numa_node");
+    if (value.empty()) {
+        return -1;
+    }
+    try {
+        return std::stoi(value);
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+std::vector<int> CpuTopology::nodeCpus(int node) {
+    if (node < 0) {
+        return {};
+    }
+    return parseCpuList(readSysfs(
+        "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+}
+
+std::vector<int> CpuTopology::parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        if (token.empty()) {
+            continue;
+        }
+        try {
+            const size_t dash = token.find('-');
+            if (dash == std::string::npos) {
+                cpus.push_back(std::stoi(token));
+            } else {
+                const int lo = std::stoi(token.substr(0, dash));
+                const int hi = std::stoi(token.substr(dash + 1));
+                for (int cpu = lo; cpu <= hi; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+        } catch (const std::exception&) {
+            return {};  // 格式错误时整体放弃，宁可不绑核
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> CpuTopology::resolveCpuSet(const std::string& spec,
+                                            const std::string& interface) {
+    if (spec.empty()) {
+        return {};
+    }
+    if (spec == "auto") {
+        const int node = nicNumaNode(interface);
+        if (node < 0) {
+            NIPS_DEBUG("网卡 {} 的NUMA节点未知（单节点机器或虚拟接口），不绑核",
+                       interface);
+            return {};
+        }
+        return nodeCpus(node);
+    }
+    return parseCpuList(spec);
+}
+
+bool CpuTopology::pinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        NIPS_WARN("线程绑核失败（{} 个CPU），继续不绑核运行", cpus.size());
+        return false;
+    }
+    return true;
+}
+
+} // namespace common
+} // namespace nips
@@ -0,0 +1,203 @@
+#include "common/telemetry.hpp"
+#include "common/logger.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace nips {
+namespace common {
+
+namespace {
+
+// 阶段名（Prometheus标签值）
+const char* kStageNames[kStageCount] = {
+    "flow_update",
+    "inference",
+    "threat_detect",
+    "response",
+};
+
+// 纳秒值到log2桶下标
+inline size_t bucketIndex(uint64_t nanos) {
+    if (nanos == 0) return 0;
+    const size_t bits = 64 - __builtin_clzll(nanos);
+    return bits < Telemetry::kBuckets ? bits : Telemetry::kBuckets - 1;
+}
+
+} // namespace
+
+Telemetry& Telemetry::getInstance() {
+    static Telemetry instance;
+    return instance;
+}
+
+Telemetry::~Telemetry() {
+    stopExporter();
+}
+
+size_t Telemetry::threadSlot() {
+    thread_local size_t slot = SIZE_MAX;
+    if (slot == SIZE_MAX) {
+        slot = thread_count_.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= kMaxThreads) {
+            // 超出槽数的线程共享最后一个槽（计数仍正确，仅有少量争用）
+            slot = kMaxThreads - 1;
+        }
+    }
+    return slot;
+}
+
+void Telemetry::record(TelemetryStage stage, uint64_t nanos) {
+    record(stage, nanos, 1);
+}
+
+void Telemetry::record(TelemetryStage stage, uint64_t nanos, uint64_t events) {
+    StageSlot& s = slots_[threadSlot()][stage];
+    s.buckets[bucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+    s.sum_ns.fetch_add(nanos, std::memory_order_relaxed);
+    s.events.fetch_add(events, std::memory_order_relaxed);
+}
+
+void Telemetry::registerGauge(const std::string& name, std::function<uint64_t()> fn) {
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    gauges_.push_back(Gauge{name, std::move(fn)});
+}
+
+std::string Telemetry::render() const {
+    std::ostringstream out;
+
+    // 各阶段延迟直方图（秒），桶界为2^i纳秒
+    out << "# HELP nips_stage_latency_seconds 各管线阶段耗时分布\n";
+    out << "# TYPE nips_stage_latency_seconds histogram\n";
+    const size_t threads = std::min<size_t>(
+        thread_count_.load(std::memory_order_relaxed), kMaxThreads);
+    for (int stage = 0; stage < kStageCount; ++stage) {
+        uint64_t cumulative = 0;
+        uint64_t total = 0;
+        uint64_t sum_ns = 0;
+        uint64_t events = 0;
+        uint64_t merged[kBuckets] = {0};
+        for (size_t t = 0; t < threads; ++t) {
+            const StageSlot& s = slots_[t][stage];
+            for (size_t b = 0; b < kBuckets; ++b) {
+                merged[b] += s.buckets[b].load(std::memory_order_relaxed);
+            }
+            sum_ns += s.sum_ns.load(std::memory_order_relaxed);
+            events += s.events.load(std::memory_order_relaxed);
+        }
+        for (size_t b = 0; b < kBuckets; ++b) {
+            cumulative += merged[b];
+            total += merged[b];
+            const double le = static_cast<double>(1ULL << b) * 1e-9;
+            out << "nips_stage_latency_seconds_bucket{stage=\""
+                << kStageNames[stage] << "\",le=\"" << le << "\"} "
+                << cumulative << "\n";
+        }
+        out << "nips_stage_latency_seconds_bucket{stage=\""
+            << kStageNames[stage] << "\",le=\"+Inf\"} " << total << "\n";
+        out << "nips_stage_latency_seconds_sum{stage=\"" << kStageNames[stage]
+            << "\"} " << static_cast<double>(sum_ns) * 1e-9 << "\n";
+        out << "nips_stage_latency_seconds_count{stage=\"" << kStageNames[stage]
+            << "\"} " << total << "\n";
+        // 吞吐：阶段处理的事件总数（批处理阶段大于样本数）
+        out << "nips_stage_events_total{stage=\"" << kStageNames[stage]
+            << "\"} " << events << "\n";
+    }
+
+    // 采集时求值的仪表
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    for (const auto& gauge : gauges_) {
+        out << "# TYPE " << gauge.name << " gauge\n";
+        out << gauge.name << " " << gauge.fn() << "\n";
+    }
+
+    return out.str();
+}
+
+bool Telemetry::startExporter(uint16_t port) {
+    if (running_ || port == 0) {
+        return false;
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        NIPS_ERROR("无法创建遥测监听socket: {}", strerror(errno));
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listen_fd_, 8) < 0) {
+        NIPS_ERROR("无法绑定遥测端口 {}: {}", port, strerror(errno));
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    exporter_thread_ = std::make_unique<std::thread>([this]() { exporterLoop(); });
+    NIPS_INFO("遥测端点已启动: 0.0.0.0:{}/metrics", port);
+    return true;
+}
+
+void Telemetry::exporterLoop() {
+    while (running_) {
+        struct sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        const int fd = accept(listen_fd_, reinterpret_cast<struct sockaddr*>(&peer),
+                              &peer_len);
+        if (fd < 0) {
+            if (running_) {
+                NIPS_WARN("遥测accept失败: {}", strerror(errno));
+            }
+            continue;
+        }
+
+        // 丢弃请求内容，对任意GET都回应一次完整采集
+        char buf[1024];
+        (void)!read(fd, buf, sizeof(buf));
+
+        const std::string body = render();
+        std::ostringstream response;
+        response << "HTTP/1.1 200 OK\r\n"
+                 << "Content-Type: text/plain; version=0.0.4\r\n"
+                 << "Content-Length: " << body.size() << "\r\n"
+                 << "Connection: close\r\n\r\n"
+                 << body;
+        const std::string data = response.str();
+        (void)!write(fd, data.data(), data.size());
+        close(fd);
+    }
+}
+
+void Telemetry::stopExporter() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    // 关闭监听fd使阻塞的accept返回
+    if (listen_fd_ >= 0) {
+        shutdown(listen_fd_, SHUT_RDWR);
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    if (exporter_thread_ && exporter_thread_->joinable()) {
+        exporter_thread_->join();
+    }
+    exporter_thread_.reset();
+}
+
+} // namespace common
+} // namespace nips
@@ -0,0 +1,246 @@
+#include "correlation/correlation_engine.hpp"
+#include "common/config.hpp"
+#include "common/logger.hpp"
+#include "feature/flow_key.hpp"
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nips {
+namespace correlation {
+
+namespace {
+
+// 256位哈希布隆做近似去重计数：加入O(1)，基数估计取置位数。
+// 在阈值量级（几十）下碰撞误差远小于阈值本身
+struct DistinctSketch {
+    uint64_t bits[4] = {0, 0, 0, 0};
+
+    void add(uint32_t value) {
+        uint64_t h = value;
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        bits[(h >> 6) & 3] |= 1ULL << (h & 63);
+    }
+
+    void merge(const DistinctSketch& other) {
+        for (int i = 0; i < 4; ++i) {
+            bits[i] |= other.bits[i];
+        }
+    }
+
+    size_t estimate() const {
+        size_t count = 0;
+        for (int i = 0; i < 4; ++i) {
+            count += __builtin_popcountll(bits[i]);
+        }
+        return count;
+    }
+};
+
+// 秒级环形桶：桶记录自己的绝对秒，游标转回来时惰性清零
+struct Bucket {
+    uint32_t second = 0;
+    uint32_t flows = 0;
+    uint32_t syn_no_ack = 0;
+    DistinctSketch ports;
+    DistinctSketch hosts;
+};
+
+// 告警类型下标（每源每类型独立冷却）
+enum AlertKind { kAlertPortScan = 0, kAlertHostSweep = 1, kAlertSynScan = 2, kAlertKinds = 3 };
+
+} // namespace
+
+class CorrelationEngine::Impl {
+public:
+    bool init() {
+        auto cfg = common::Config::getInstance().snapshot();
+        window_ = cfg->detection.correlation_window_seconds;
+        port_threshold_ = cfg->detection.correlation_port_threshold;
+        host_threshold_ = cfg->detection.correlation_host_threshold;
+        if (window_ == 0 || port_threshold_ == 0 || host_threshold_ == 0) {
+            NIPS_ERROR("关联引擎参数无效: window={}, port_threshold={}, host_threshold={}",
+                       window_, port_threshold_, host_threshold_);
+            return false;
+        }
+        NIPS_INFO("关联引擎已初始化: 窗口 {}s, 端口阈值 {}, 主机阈值 {}",
+                  window_, port_threshold_, host_threshold_);
+        return true;
+    }
+
+    void observe(const feature::FlowFeatures& features) {
+        if (features.flow_key_hi == 0 && features.flow_key_lo == 0) {
+            return;
+        }
+        const uint32_t src_ip = static_cast<uint32_t>(features.flow_key_hi >> 32);
+        const uint32_t dst_ip = static_cast<uint32_t>(features.flow_key_hi);
+        const uint16_t dst_port = static_cast<uint16_t>(features.flow_key_lo >> 8);
+        // 流键低字40-47位是地址族：IPv6槽位存折叠地址，渲染与
+        // 源跟踪都必须带上版本，否则v6折叠会冒充成v4点分十进制
+        const auto ip_version = static_cast<uint8_t>(features.flow_key_lo >> 40);
+        const uint32_t now = static_cast<uint32_t>(std::time(nullptr));
+
+        // 流表热路径里connection_pattern[0..5]是原始标志计数
+        const bool syn_no_ack = features.connection_pattern[0] > 0.0f &&
+                                features.connection_pattern[1] == 0.0f;
+
+        detection::ThreatInfo alert;
+        bool emit = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            SourceState& state = ensureSource(
+                static_cast<uint64_t>(ip_version) << 32 | src_ip);
+            state.last_seen = now;
+
+            // O(1)落桶：游标转回旧秒的桶时惰性清零
+            Bucket& bucket = state.buckets[now % window_];
+            if (bucket.second != now) {
+                bucket = Bucket{};
+                bucket.second = now;
+            }
+            bucket.flows++;
+            if (syn_no_ack) {
+                bucket.syn_no_ack++;
+            }
+            bucket.ports.add(dst_port);
+            bucket.hosts.add(dst_ip);
+
+            emit = evaluate(src_ip, ip_version, state, now, alert);
+        }
+        // 告警在锁外交付，响应链的耗时不阻塞其他观察线程
+        if (emit && callback_) {
+            callback_(alert);
+        }
+    }
+
+    void advance(uint32_t now) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 回收两个窗口没有活动的源；环形桶本身随游标惰性清零
+        for (auto it = sources_.begin(); it != sources_.end();) {
+            if (now - it->second.last_seen > 2 * window_) {
+                it = sources_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    size_t trackedSources() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sources_.size();
+    }
+
+    AlertCallback callback_;
+
+private:
+    struct SourceState {
+        std::vector<Bucket> buckets;
+        uint32_t last_seen = 0;
+        uint32_t last_alert[kAlertKinds] = {0, 0, 0};
+    };
+
+    // 源键：地址族 | 源地址（v4地址与v6折叠不混在同一计数窗口）
+    SourceState& ensureSource(uint64_t source_key) {
+        SourceState& state = sources_[source_key];
+        if (state.buckets.empty()) {
+            state.buckets.resize(window_);
+        }
+        return state;
+    }
+
+    // 聚合窗口内的桶并对照阈值；命中且不在冷却期时填充告警
+    bool evaluate(uint32_t src_ip, uint8_t ip_version, SourceState& state,
+                  uint32_t now, detection::ThreatInfo& alert) {
+        DistinctSketch ports;
+        DistinctSketch hosts;
+        uint32_t flows = 0;
+        uint32_t syn_no_ack = 0;
+        for (const Bucket& bucket : state.buckets) {
+            if (now - bucket.second < window_) {
+                ports.merge(bucket.ports);
+                hosts.merge(bucket.hosts);
+                flows += bucket.flows;
+                syn_no_ack += bucket.syn_no_ack;
+            }
+        }
+
+        int kind = -1;
+        std::string type;
+        std::string detail;
+        if (ports.estimate() >= port_threshold_) {
+            kind = kAlertPortScan;
+            type = "correlated_port_scan";
+            detail = "窗口内 " + std::to_string(ports.estimate()) + " 个不同目的端口";
+        } else if (hosts.estimate() >= host_threshold_) {
+            kind = kAlertHostSweep;
+            type = "correlated_host_sweep";
+            detail = "窗口内 " + std::to_string(hosts.estimate()) + " 个不同目的主机";
+        } else if (flows >= port_threshold_ && syn_no_ack * 2 >= flows) {
+            // 半数以上的流SYN后无ACK：连接从未完成的探测模式
+            kind = kAlertSynScan;
+            type = "correlated_syn_scan";
+            detail = "窗口内 " + std::to_string(syn_no_ack) + "/" +
+                     std::to_string(flows) + " 个流SYN无ACK";
+        }
+        if (kind < 0) {
+            return false;
+        }
+
+        // 每源每类型一个窗口内只告警一次
+        if (now - state.last_alert[kind] < window_) {
+            return false;
+        }
+        state.last_alert[kind] = now;
+
+        alert.id = "CORR-" + std::to_string(
+            alert_seq_.fetch_add(1, std::memory_order_relaxed) + 1);
+        alert.type = type;
+        alert.level = detection::ThreatLevel::HIGH;
+        alert.timestamp = std::chrono::system_clock::now();
+        alert.source_ip = detection::renderFlowAddress(src_ip, ip_version);
+        alert.confidence = 0.9f;
+        alert.indicators.push_back("sliding_window_correlation");
+        alert.description = "源 " + alert.source_ip + " " + detail;
+        alert.mitigation_suggestions.push_back("对源IP限速或临时封禁");
+        alert.mitigation_suggestions.push_back("核查该源近期的全部连接记录");
+        return true;
+    }
+
+    std::unordered_map<uint64_t, SourceState> sources_;
+    mutable std::mutex mutex_;
+    std::atomic<uint64_t> alert_seq_{0};
+    size_t window_ = 60;
+    size_t port_threshold_ = 20;
+    size_t host_threshold_ = 20;
+};
+
+CorrelationEngine::CorrelationEngine() : pimpl_(std::make_unique<Impl>()) {}
+
+CorrelationEngine::~CorrelationEngine() = default;
+
+bool CorrelationEngine::init() {
+    return pimpl_->init();
+}
+
+void CorrelationEngine::setAlertCallback(AlertCallback callback) {
+    pimpl_->callback_ = std::move(callback);
+}
+
+void CorrelationEngine::observe(const feature::FlowFeatures& features) {
+    pimpl_->observe(features);
+}
+
+void CorrelationEngine::advance(uint32_t now) {
+    pimpl_->advance(now);
+}
+
+size_t CorrelationEngine::trackedSources() const {
+    return pimpl_->trackedSources();
+}
+
+} // namespace correlation
+} // namespace nips
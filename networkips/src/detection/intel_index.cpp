@@ -0,0 +1,205 @@
+#include "detection/intel_index.hpp"
+#include "common/logger.hpp"
+#include <yaml-cpp/yaml.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <deque>
+
+namespace nips {
+namespace detection {
+
+namespace {
+
+// 解析 "a.b.c.d" 或 "a.b.c.d/len" 为主机序闭区间；失败返回false
+bool parseIpOrCidr(const std::string& value, uint32_t& start, uint32_t& end) {
+    std::string addr = value;
+    int prefix_len = 32;
+
+    const size_t slash = value.find('/');
+    if (slash != std::string::npos) {
+        addr = value.substr(0, slash);
+        try {
+            prefix_len = std::stoi(value.substr(slash + 1));
+        } catch (const std::exception&) {
+            return false;
+        }
+        if (prefix_len < 0 || prefix_len > 32) {
+            return false;
+        }
+    }
+
+    struct in_addr parsed;
+    if (inet_pton(AF_INET, addr.c_str(), &parsed) != 1) {
+        return false;
+    }
+
+    const uint32_t base = ntohl(parsed.s_addr);
+    const uint32_t mask = prefix_len == 0 ? 0 : ~uint32_t(0) << (32 - prefix_len);
+    start = base & mask;
+    end = start | ~mask;
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<const IntelIndex> IntelIndex::build(const std::string& intel_path) {
+    YAML::Node root;
+    try {
+        // JSON是YAML的子集，情报文件复用yaml-cpp解析
+        root = YAML::LoadFile(intel_path);
+    } catch (const std::exception& e) {
+        NIPS_ERROR("无法解析威胁情报源 {}: {}", intel_path, e.what());
+        return nullptr;
+    }
+
+    auto index = std::shared_ptr<IntelIndex>(new IntelIndex());
+    index->nodes_.emplace_back();  // AC根节点
+
+    std::vector<Range> raw_ranges;
+    size_t skipped = 0;
+
+    const auto indicators = root["indicators"];
+    if (indicators && indicators.IsSequence()) {
+        for (const auto& item : indicators) {
+            const auto type = item["type"] ? item["type"].as<std::string>() : "";
+            const auto value = item["value"] ? item["value"].as<std::string>() : "";
+            if (value.empty()) {
+                skipped++;
+                continue;
+            }
+
+            if (type == "ip" || type == "cidr") {
+                Range range;
+                if (parseIpOrCidr(value, range.start, range.end)) {
+                    raw_ranges.push_back(range);
+                } else {
+                    skipped++;
+                }
+            } else if (type == "domain" || type == "string") {
+                index->addPattern(value);
+            } else {
+                skipped++;
+            }
+        }
+    }
+
+    // 排序并合并重叠区间，查询只需一次二分
+    std::sort(raw_ranges.begin(), raw_ranges.end(),
+              [](const Range& a, const Range& b) { return a.start < b.start; });
+    for (const auto& range : raw_ranges) {
+        if (!index->ranges_.empty() &&
+            (range.start <= index->ranges_.back().end ||
+             (index->ranges_.back().end != ~uint32_t(0) &&
+              range.start == index->ranges_.back().end + 1))) {
+            index->ranges_.back().end = std::max(index->ranges_.back().end, range.end);
+        } else {
+            index->ranges_.push_back(range);
+        }
+    }
+
+    index->compileAutomaton();
+
+    NIPS_INFO("威胁情报索引已编译: {} 个IP区间, {} 个字符串指标, {} 个AC节点"
+              "{}", index->ranges_.size(), index->pattern_count_,
+              index->nodes_.size(),
+              skipped > 0 ? " (跳过 " + std::to_string(skipped) + " 条无效指标)" : "");
+    return index;
+}
+
+void IntelIndex::addPattern(const std::string& pattern) {
+    int32_t state = 0;
+    for (const char ch : pattern) {
+        const uint8_t c = static_cast<uint8_t>(ch);
+        auto& next = nodes_[state].next;
+        const auto it = std::lower_bound(next.begin(), next.end(), c,
+            [](const std::pair<uint8_t, int32_t>& edge, uint8_t key) {
+                return edge.first < key;
+            });
+        if (it != next.end() && it->first == c) {
+            state = it->second;
+        } else {
+            const int32_t created = static_cast<int32_t>(nodes_.size());
+            nodes_.emplace_back();
+            nodes_[state].next.insert(it, {c, created});
+            state = created;
+        }
+    }
+    if (!nodes_[state].output) {
+        nodes_[state].output = true;
+        pattern_count_++;
+    }
+}
+
+void IntelIndex::compileAutomaton() {
+    // BFS计算fail链；输出标记沿fail链传播，
+    // 查询时命中判断只看当前节点一位
+    std::deque<int32_t> queue;
+    for (const auto& [c, child] : nodes_[0].next) {
+        (void)c;
+        nodes_[child].fail = 0;
+        queue.push_back(child);
+    }
+
+    while (!queue.empty()) {
+        const int32_t state = queue.front();
+        queue.pop_front();
+        for (const auto& [c, child] : nodes_[state].next) {
+            nodes_[child].fail = step(nodes_[state].fail, c);
+            nodes_[child].output =
+                nodes_[child].output || nodes_[nodes_[child].fail].output;
+            queue.push_back(child);
+        }
+    }
+}
+
+int32_t IntelIndex::step(int32_t state, uint8_t c) const {
+    for (;;) {
+        const auto& next = nodes_[state].next;
+        const auto it = std::lower_bound(next.begin(), next.end(), c,
+            [](const std::pair<uint8_t, int32_t>& edge, uint8_t key) {
+                return edge.first < key;
+            });
+        if (it != next.end() && it->first == c) {
+            return it->second;
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = nodes_[state].fail;
+    }
+}
+
+bool IntelIndex::matchIp(uint32_t ip) const {
+    // 首个start大于ip的区间的前驱即候选
+    const auto it = std::upper_bound(ranges_.begin(), ranges_.end(), ip,
+        [](uint32_t key, const Range& range) { return key < range.start; });
+    if (it == ranges_.begin()) {
+        return false;
+    }
+    return ip <= std::prev(it)->end;
+}
+
+bool IntelIndex::matchIp(const std::string& ip) const {
+    struct in_addr parsed;
+    if (inet_pton(AF_INET, ip.c_str(), &parsed) != 1) {
+        return false;
+    }
+    return matchIp(ntohl(parsed.s_addr));
+}
+
+bool IntelIndex::matchString(const std::string& text) const {
+    if (pattern_count_ == 0) {
+        return false;
+    }
+    int32_t state = 0;
+    for (const char ch : text) {
+        state = step(state, static_cast<uint8_t>(ch));
+        if (nodes_[state].output) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace detection
+} // namespace nips
@@ -0,0 +1,403 @@
+#include "detection/threat_detector.hpp"
+#include "detection/intel_index.hpp"
+#include "common/config.hpp"
+#include "common/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace nips {
+namespace detection {
+
+namespace {
+
+// 历史环中的平凡可拷贝威胁记录：seqlock下读方直接memcpy，
+// 不能放std::string（撕裂读到重分配中的串是未定义行为）
+struct ThreatRecord {
+    char id[32];
+    char type[32];
+    char source_ip[46];
+    char destination_ip[46];
+    char description[160];
+    uint16_t source_port;
+    uint16_t destination_port;
+    int32_t level;
+    float confidence;
+    int64_t timestamp_s;
+};
+
+inline void copyField(char* dst, size_t cap, const std::string& src) {
+    const size_t n = std::min(cap - 1, src.size());
+    std::memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+const char* protocolName(uint8_t protocol) {
+    switch (protocol) {
+        case IPPROTO_TCP: return "TCP";
+        case IPPROTO_UDP: return "UDP";
+        case IPPROTO_ICMP: return "ICMP";
+        default: return "OTHER";
+    }
+}
+
+const char* threatLevelName(ThreatLevel level) {
+    switch (level) {
+        case ThreatLevel::LOW: return "LOW";
+        case ThreatLevel::MEDIUM: return "MEDIUM";
+        case ThreatLevel::HIGH: return "HIGH";
+        case ThreatLevel::CRITICAL: return "CRITICAL";
+        default: return "NONE";
+    }
+}
+
+} // namespace
+
+// 只在真正产出威胁/告警时调用，正常流量不付字符串渲染的代价；
+// 关联引擎与威胁检测链共用（声明见threat_detector.hpp）
+std::string renderFlowAddress(uint32_t ip, uint8_t ip_version) {
+    if (ip_version == 6) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "v6#%08x", ip);
+        return buf;
+    }
+    char buf[INET_ADDRSTRLEN];
+    const struct in_addr addr = {htonl(ip)};
+    inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+    return buf;
+}
+
+class ThreatDetector::Impl {
+public:
+    bool init() {
+        auto cfg = common::Config::getInstance().snapshot();
+
+        thresholds_[ThreatLevel::LOW] = valueOr(cfg->detection.threat_thresholds, "low", 0.6f);
+        thresholds_[ThreatLevel::MEDIUM] = valueOr(cfg->detection.threat_thresholds, "medium", 0.75f);
+        thresholds_[ThreatLevel::HIGH] = valueOr(cfg->detection.threat_thresholds, "high", 0.85f);
+        thresholds_[ThreatLevel::CRITICAL] = valueOr(cfg->detection.threat_thresholds, "critical", 0.95f);
+        max_history_ = cfg->detection.max_threats_history > 0 ?
+            cfg->detection.max_threats_history : 1000;
+        ring_ = std::make_unique<Slot[]>(max_history_);
+        intel_source_ = cfg->detection.intel_source;
+
+        // 初始情报索引；文件缺失不是致命错误（空索引全不命中）
+        if (!intel_source_.empty()) {
+            auto index = IntelIndex::build(intel_source_);
+            if (index) {
+                std::atomic_store_explicit(&intel_, index, std::memory_order_release);
+            }
+        }
+        return true;
+    }
+
+    static float valueOr(const std::unordered_map<std::string, float>& map,
+                         const std::string& key, float fallback) {
+        const auto it = map.find(key);
+        return it != map.end() ? it->second : fallback;
+    }
+
+    // 当前情报索引快照（无锁）
+    std::shared_ptr<const IntelIndex> intelSnapshot() const {
+        return std::atomic_load_explicit(&intel_, std::memory_order_acquire);
+    }
+
+    // 每槽seqlock保护的历史环槽位
+    struct Slot {
+        std::atomic<uint32_t> seq{0};  // 奇数=写入中
+        ThreatRecord record = {};
+    };
+
+    // 写入一条历史记录：检测路径上的写方永不阻塞。
+    // 写方由批量推理回调串行化（单写者），seq奇偶标记写窗口
+    void recordThreat(const ThreatInfo& threat) {
+        level_counts_[static_cast<size_t>(threat.level)]
+            .fetch_add(1, std::memory_order_relaxed);
+
+        const uint64_t index = write_index_.load(std::memory_order_relaxed);
+        Slot& slot = ring_[index % max_history_];
+
+        slot.seq.fetch_add(1, std::memory_order_acquire);  // 进入写窗口（变奇）
+        ThreatRecord& rec = slot.record;
+        copyField(rec.id, sizeof(rec.id), threat.id);
+        copyField(rec.type, sizeof(rec.type), threat.type);
+        copyField(rec.source_ip, sizeof(rec.source_ip), threat.source_ip);
+        copyField(rec.destination_ip, sizeof(rec.destination_ip), threat.destination_ip);
+        copyField(rec.description, sizeof(rec.description), threat.description);
+        rec.source_port = threat.source_port;
+        rec.destination_port = threat.destination_port;
+        rec.level = static_cast<int32_t>(threat.level);
+        rec.confidence = threat.confidence;
+        rec.timestamp_s = std::chrono::duration_cast<std::chrono::seconds>(
+            threat.timestamp.time_since_epoch()).count();
+        slot.seq.fetch_add(1, std::memory_order_release);  // 离开写窗口（变偶）
+
+        write_index_.store(index + 1, std::memory_order_release);
+    }
+
+    // 读取一个槽位；撕裂读（seq变化或为奇）时重试
+    bool readSlot(size_t index, ThreatRecord& out) const {
+        const Slot& slot = ring_[index % max_history_];
+        for (int attempt = 0; attempt < 8; ++attempt) {
+            const uint32_t before = slot.seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            out = slot.record;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;  // 写方持续覆盖该槽，放弃这条记录
+    }
+
+    static ThreatInfo toThreatInfo(const ThreatRecord& rec) {
+        ThreatInfo threat;
+        threat.id = rec.id;
+        threat.type = rec.type;
+        threat.source_ip = rec.source_ip;
+        threat.destination_ip = rec.destination_ip;
+        threat.description = rec.description;
+        threat.source_port = rec.source_port;
+        threat.destination_port = rec.destination_port;
+        threat.level = static_cast<ThreatLevel>(rec.level);
+        threat.confidence = rec.confidence;
+        threat.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::seconds(rec.timestamp_s));
+        return threat;
+    }
+
+    std::unordered_map<ThreatLevel, float> thresholds_;
+    std::shared_ptr<const IntelIndex> intel_;
+    std::string intel_source_;
+
+    // 定容seqlock历史环 + 每等级原子计数；
+    // 仪表盘轮询不再与检测路径抢锁
+    std::unique_ptr<Slot[]> ring_;
+    std::atomic<uint64_t> write_index_{0};
+    std::atomic<uint64_t> level_counts_[5] = {};
+    size_t max_history_ = 1000;
+    std::atomic<uint64_t> threat_seq_{0};
+};
+
+ThreatDetector::ThreatDetector() : pimpl_(std::make_unique<Impl>()) {}
+
+ThreatDetector::~ThreatDetector() = default;
+
+bool ThreatDetector::init(const std::string& config_path) {
+    (void)config_path;  // 配置经Config单例快照读取
+    if (!pimpl_->init()) {
+        return false;
+    }
+    NIPS_INFO("威胁检测器已初始化");
+    return true;
+}
+
+ThreatInfo ThreatDetector::detectThreat(const feature::FlowFeatures& features,
+                                        const ml::DetectionResult& anomaly_result) {
+    ThreatInfo threat;
+    threat.timestamp = std::chrono::system_clock::now();
+    threat.level = evaluateThreatLevel(anomaly_result.anomaly_score,
+                                       anomaly_result.confidence);
+    threat.confidence = anomaly_result.confidence;
+    threat.indicators = anomaly_result.indicators;
+
+    if (threat.level == ThreatLevel::NONE) {
+        return threat;
+    }
+
+    // 流身份从打包键惰性渲染：只有越过威胁阈值的流才走到这里
+    if (features.flow_key_hi != 0 || features.flow_key_lo != 0) {
+        const auto ip_version = static_cast<uint8_t>(features.flow_key_lo >> 40);
+        threat.source_ip = renderFlowAddress(
+            static_cast<uint32_t>(features.flow_key_hi >> 32), ip_version);
+        threat.destination_ip = renderFlowAddress(
+            static_cast<uint32_t>(features.flow_key_hi), ip_version);
+        threat.source_port = static_cast<uint16_t>(features.flow_key_lo >> 24);
+        threat.destination_port = static_cast<uint16_t>(features.flow_key_lo >> 8);
+        threat.protocol = protocolName(static_cast<uint8_t>(features.flow_key_lo));
+    }
+
+    threat.type = identifyThreatType(features, anomaly_result);
+    threat.id = "THREAT-" + std::to_string(
+        pimpl_->threat_seq_.fetch_add(1, std::memory_order_relaxed) + 1);
+    threat.description = "异常分数 " + std::to_string(anomaly_result.anomaly_score) +
+                         ", 类型 " + threat.type;
+
+    // 情报命中至少提升到HIGH
+    if (matchThreatIntelligence(threat)) {
+        threat.indicators.push_back("threat_intel_match");
+        if (threat.level < ThreatLevel::HIGH) {
+            threat.level = ThreatLevel::HIGH;
+        }
+    }
+
+    threat.mitigation_suggestions = generateMitigationSuggestions(threat);
+    pimpl_->recordThreat(threat);
+    return threat;
+}
+
+ThreatLevel ThreatDetector::evaluateThreatLevel(float anomaly_score, float confidence) {
+    // 低置信度结果降权，避免模型边界样本直接触发响应
+    const float score = anomaly_score * (0.5f + 0.5f * confidence);
+    if (score >= pimpl_->thresholds_[ThreatLevel::CRITICAL]) return ThreatLevel::CRITICAL;
+    if (score >= pimpl_->thresholds_[ThreatLevel::HIGH]) return ThreatLevel::HIGH;
+    if (score >= pimpl_->thresholds_[ThreatLevel::MEDIUM]) return ThreatLevel::MEDIUM;
+    if (score >= pimpl_->thresholds_[ThreatLevel::LOW]) return ThreatLevel::LOW;
+    return ThreatLevel::NONE;
+}
+
+std::string ThreatDetector::identifyThreatType(const feature::FlowFeatures& features,
+                                               const ml::DetectionResult& anomaly_result) {
+    (void)anomaly_result;
+
+    const float packets = features.packet_count > 0 ?
+        static_cast<float>(features.packet_count) : 1.0f;
+    const float syn_ratio = features.connection_pattern[0];
+    const float ack_ratio = features.connection_pattern[1];
+    const float rst_ratio = features.connection_pattern[3];
+
+    // 按累积特征做粗分类；精细归因交给上层关联分析
+    if (syn_ratio > 0.5f && ack_ratio < 0.1f) {
+        return features.packets_per_second > 1000.0f ? "syn_flood" : "port_scan";
+    }
+    if (rst_ratio > 0.3f) {
+        return "connection_probe";
+    }
+    if (features.avg_payload_entropy > 7.5f && features.bytes_per_second > 1e6f) {
+        return "data_exfiltration";
+    }
+    if (features.packets_per_second > 10000.0f) {
+        return "volumetric_flood";
+    }
+    if (features.mean_packet_size < 100.0f && packets > 100.0f) {
+        return "beaconing";
+    }
+    return "anomalous_traffic";
+}
+
+bool ThreatDetector::matchThreatIntelligence(const ThreatInfo& threat) {
+    auto intel = pimpl_->intelSnapshot();
+    if (!intel) {
+        return false;
+    }
+
+    if (!threat.source_ip.empty() && intel->matchIp(threat.source_ip)) {
+        return true;
+    }
+    if (!threat.destination_ip.empty() && intel->matchIp(threat.destination_ip)) {
+        return true;
+    }
+    for (const auto& indicator : threat.indicators) {
+        if (intel->matchString(indicator)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreatDetector::updateThreatIntelligence(const std::string& intel_source) {
+    // 索引整体重建后原子换入；旧索引由仍在查询的线程引用计数保活
+    auto index = IntelIndex::build(intel_source);
+    if (!index) {
+        NIPS_WARN("威胁情报更新失败，保留现有索引: {}", intel_source);
+        return;
+    }
+    pimpl_->intel_source_ = intel_source;
+    std::atomic_store_explicit(&pimpl_->intel_, index, std::memory_order_release);
+    NIPS_INFO("威胁情报已更新: {} ({} 个IP区间, {} 个字符串指标)",
+              intel_source, index->ipRangeCount(), index->patternCount());
+}
+
+std::unordered_map<ThreatLevel, size_t> ThreatDetector::getThreatStatistics() {
+    std::unordered_map<ThreatLevel, size_t> stats;
+    for (size_t i = 0; i < 5; ++i) {
+        const uint64_t count = pimpl_->level_counts_[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            stats[static_cast<ThreatLevel>(i)] = count;
+        }
+    }
+    return stats;
+}
+
+void ThreatDetector::setThreatThresholds(
+    const std::unordered_map<ThreatLevel, float>& thresholds) {
+    for (const auto& [level, value] : thresholds) {
+        pimpl_->thresholds_[level] = value;
+    }
+}
+
+std::vector<ThreatInfo> ThreatDetector::getRecentThreats(size_t count) {
+    std::vector<ThreatInfo> recent;
+    const uint64_t written = pimpl_->write_index_.load(std::memory_order_acquire);
+    const size_t available = static_cast<size_t>(
+        std::min<uint64_t>(written, pimpl_->max_history_));
+    const size_t n = std::min(count, available);
+    recent.reserve(n);
+
+    // 从最新向旧读；被写方追上覆盖的槽跳过
+    for (size_t i = 0; i < n; ++i) {
+        ThreatRecord record;
+        if (pimpl_->readSlot(static_cast<size_t>(written - 1 - i), record)) {
+            recent.push_back(Impl::toThreatInfo(record));
+        }
+    }
+    return recent;
+}
+
+bool ThreatDetector::exportThreatReport(const std::string& file_path) {
+    std::ofstream out(file_path);
+    if (!out) {
+        NIPS_ERROR("无法写入威胁报告: {}", file_path);
+        return false;
+    }
+
+    // 从旧到新导出当前环内容
+    const uint64_t written = pimpl_->write_index_.load(std::memory_order_acquire);
+    const uint64_t available = std::min<uint64_t>(written, pimpl_->max_history_);
+    for (uint64_t i = written - available; i < written; ++i) {
+        ThreatRecord record;
+        if (!pimpl_->readSlot(static_cast<size_t>(i), record)) {
+            continue;
+        }
+        out << "{\"id\":\"" << record.id
+            << "\",\"type\":\"" << record.type
+            << "\",\"level\":\"" << threatLevelName(static_cast<ThreatLevel>(record.level))
+            << "\",\"confidence\":" << record.confidence
+            << ",\"timestamp\":" << record.timestamp_s
+            << ",\"description\":\"" << record.description << "\"}\n";
+    }
+    return true;
+}
+
+std::vector<std::string> ThreatDetector::generateMitigationSuggestions(
+    const ThreatInfo& threat) {
+    std::vector<std::string> suggestions;
+    if (threat.type == "syn_flood" || threat.type == "volumetric_flood") {
+        suggestions.push_back("对源地址启用速率限制");
+        suggestions.push_back("检查上游是否可启用SYN cookies");
+    } else if (threat.type == "port_scan" || threat.type == "connection_probe") {
+        suggestions.push_back("封禁源地址并核查暴露端口");
+    } else if (threat.type == "data_exfiltration") {
+        suggestions.push_back("阻断外联并审计目的地址");
+        suggestions.push_back("核查主机是否失陷");
+    } else if (threat.type == "beaconing") {
+        suggestions.push_back("排查周期性外联的进程");
+    } else {
+        suggestions.push_back("人工研判流量样本");
+    }
+    if (threat.level >= ThreatLevel::HIGH) {
+        suggestions.push_back("上报安全运营值班");
+    }
+    return suggestions;
+}
+
+} // namespace detection
+} // namespace nips
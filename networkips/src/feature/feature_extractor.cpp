@@ -1,12 +1,11 @@
 #include "feature/feature_extractor.hpp"
+#include "feature/flow_key.hpp"
+#include "feature/simd_kernels.hpp"
 #include "common/logger.hpp"
 #include <cmath>
 #include <algorithm>
 #include <unordered_map>
-#include <netinet/ip.h>
-#include <netinet/tcp.h>
-#include <netinet/udp.h>
-#include <arpa/inet.h>
+#include <netinet/in.h>
 
 namespace nips {
 namespace feature {
@@ -18,22 +17,67 @@ FeatureExtractor::FeatureExtractor() {
 
 FeatureExtractor::~FeatureExtractor() = default;
 
+ProtocolIndex protocolIndex(uint8_t ip_protocol) {
+    switch (ip_protocol) {
+        case IPPROTO_TCP: return kProtoTcp;
+        case IPPROTO_UDP: return kProtoUdp;
+        case IPPROTO_ICMP: return kProtoIcmp;
+        default: return kProtoOther;
+    }
+}
+
+unsigned featureMaskFromNames(const std::vector<std::string>& names) {
+    unsigned mask = 0;
+    for (const auto& name : names) {
+        if (name == "basic_stats") {
+            mask |= kFeatBasicStats;
+        } else if (name == "protocol_distribution") {
+            mask |= kFeatProtocolDistribution;
+        } else if (name == "payload_entropy") {
+            mask |= kFeatPayloadEntropy;
+        } else if (name == "time_features") {
+            mask |= kFeatTimeFeatures;
+        } else if (name == "connection_pattern") {
+            mask |= kFeatConnectionPattern;
+        } else {
+            NIPS_WARN("未知的特征组名 '{}'，已忽略", name);
+        }
+    }
+    // 列表为空视为全开，避免配置缺失时静默产出全零特征
+    return mask != 0 ? mask : kFeatAll;
+}
+
 FlowFeatures FeatureExtractor::extractFeatures(const std::vector<capture::PacketInfo>& packets) {
+    std::vector<const capture::PacketInfo*> ptrs;
+    ptrs.reserve(packets.size());
+    for (const auto& packet : packets) {
+        ptrs.push_back(&packet);
+    }
+    return extractFeaturesImpl(ptrs.data(), ptrs.size());
+}
+
+FlowFeatures FeatureExtractor::extractFeatures(const capture::PacketInfo& packet) {
+    const capture::PacketInfo* ptr = &packet;
+    return extractFeaturesImpl(&ptr, 1);
+}
+
+FlowFeatures FeatureExtractor::extractFeaturesImpl(const capture::PacketInfo* const* packets,
+                                                   size_t count) {
     FlowFeatures features;
-    if (packets.empty()) {
+    if (count == 0) {
         return features;
     }
 
     // 基本流量特征
-    features.packet_count = packets.size();
+    features.packet_count = count;
     features.byte_count = 0;
-    for (const auto& packet : packets) {
-        features.byte_count += packet.length;
+    for (size_t i = 0; i < count; ++i) {
+        features.byte_count += packets[i]->length;
     }
 
     // 计算时间特征
-    auto start_time = packets.front().timestamp;
-    auto end_time = packets.back().timestamp;
+    auto start_time = packets[0]->timestamp;
+    auto end_time = packets[count - 1]->timestamp;
     features.duration = end_time - start_time;
     features.packets_per_second = features.packet_count / (features.duration + 1e-6);
     features.bytes_per_second = features.byte_count / (features.duration + 1e-6);
@@ -41,101 +85,71 @@ FlowFeatures FeatureExtractor::extractFeatures(const std::vector<capture::Packet
     // 计算统计特征
     std::vector<float> packet_sizes;
     std::vector<float> inter_arrival_times;
-    packet_sizes.reserve(packets.size());
-    inter_arrival_times.reserve(packets.size() - 1);
+    packet_sizes.reserve(count);
+    inter_arrival_times.reserve(count - 1);
 
-    for (size_t i = 0; i < packets.size(); ++i) {
-        packet_sizes.push_back(packets[i].length);
+    for (size_t i = 0; i < count; ++i) {
+        packet_sizes.push_back(packets[i]->length);
         if (i > 0) {
-            inter_arrival_times.push_back(packets[i].timestamp - packets[i-1].timestamp);
+            inter_arrival_times.push_back(packets[i]->timestamp - packets[i-1]->timestamp);
         }
     }
 
-    // 计算均值
-    features.mean_packet_size = std::accumulate(packet_sizes.begin(), packet_sizes.end(), 0.0f) / packet_sizes.size();
-    features.mean_inter_arrival_time = std::accumulate(inter_arrival_times.begin(), inter_arrival_times.end(), 0.0f) / inter_arrival_times.size();
-
-    // 计算标准差
-    float sum_sq_diff_size = 0.0f;
-    float sum_sq_diff_time = 0.0f;
-    for (size_t i = 0; i < packet_sizes.size(); ++i) {
-        float diff = packet_sizes[i] - features.mean_packet_size;
-        sum_sq_diff_size += diff * diff;
-    }
-    for (size_t i = 0; i < inter_arrival_times.size(); ++i) {
-        float diff = inter_arrival_times[i] - features.mean_inter_arrival_time;
-        sum_sq_diff_time += diff * diff;
-    }
-    features.std_packet_size = std::sqrt(sum_sq_diff_size / packet_sizes.size());
-    features.std_inter_arrival_time = std::sqrt(sum_sq_diff_time / inter_arrival_times.size());
-
-    // 协议分布
-    std::unordered_map<std::string, int> protocol_counts;
-    for (const auto& packet : packets) {
-        if (packet.data.size() < 34) continue;  // 最小IP头+TCP/UDP头
-        
-        struct ip* ip_header = (struct ip*)(packet.data.data() + 14);  // 跳过以太网头
-        if (ip_header->ip_v != 4) continue;
-
-        std::string protocol;
-        switch (ip_header->ip_p) {
-            case IPPROTO_TCP:
-                protocol = "TCP";
-                break;
-            case IPPROTO_UDP:
-                protocol = "UDP";
-                break;
-            case IPPROTO_ICMP:
-                protocol = "ICMP";
-                break;
-            default:
-                protocol = "OTHER";
-        }
-        protocol_counts[protocol]++;
+    // 单遍融合的均值/方差（SIMD内核）
+    float size_variance = 0.0f;
+    float iat_variance = 0.0f;
+    simd::meanVariance(packet_sizes.data(), packet_sizes.size(),
+                       features.mean_packet_size, size_variance);
+    simd::meanVariance(inter_arrival_times.data(), inter_arrival_times.size(),
+                       features.mean_inter_arrival_time, iat_variance);
+    features.std_packet_size = std::sqrt(size_variance);
+    features.std_inter_arrival_time = std::sqrt(iat_variance);
+
+    // 协议分布（定长数组计数，无字符串哈希；头部已在捕获阶段解析）
+    uint32_t protocol_counts[kProtoCount] = {0};
+    for (size_t i = 0; i < count; ++i) {
+        const auto& parsed = packets[i]->parsed;
+        if (!parsed.valid) continue;
+
+        protocol_counts[protocolIndex(parsed.protocol)]++;
     }
 
     // 计算协议分布比例
-    for (const auto& [protocol, count] : protocol_counts) {
-        features.protocol_distribution[protocol] = static_cast<float>(count) / packets.size();
+    for (int i = 0; i < kProtoCount; ++i) {
+        features.protocol_distribution[i] = static_cast<float>(protocol_counts[i]) / count;
     }
 
-    // 计算负载熵值
-    features.payload_entropy.clear();
-    for (const auto& packet : packets) {
-        if (packet.data.size() > 34) {  // 有负载
-            features.payload_entropy.push_back(calculateEntropy(
-                std::vector<uint8_t>(packet.data.begin() + 34, packet.data.end())
-            ));
+    // 计算负载熵值（直接累积均值/最大值）
+    float entropy_sum = 0.0f;
+    uint32_t entropy_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& packet = *packets[i];
+        if (packet.parsed.payload_length > 0) {  // 有负载
+            const float entropy = calculateEntropy(
+                packet.data() + packet.parsed.payload_offset,
+                packet.parsed.payload_length);
+            entropy_sum += entropy;
+            features.max_payload_entropy = std::max(features.max_payload_entropy, entropy);
+            entropy_count++;
         }
     }
-
-    // 计算端口使用模式
-    features.port_usage_pattern.resize(65536, 0.0f);
-    for (const auto& packet : packets) {
-        if (packet.data.size() < 34) continue;
-        
-        struct ip* ip_header = (struct ip*)(packet.data.data() + 14);
-        if (ip_header->ip_p == IPPROTO_TCP) {
-            struct tcphdr* tcp_header = (struct tcphdr*)((uint8_t*)ip_header + (ip_header->ip_hl << 2));
-            features.port_usage_pattern[ntohs(tcp_header->source)] += 1.0f;
-            features.port_usage_pattern[ntohs(tcp_header->dest)] += 1.0f;
-        } else if (ip_header->ip_p == IPPROTO_UDP) {
-            struct udphdr* udp_header = (struct udphdr*)((uint8_t*)ip_header + (ip_header->ip_hl << 2));
-            features.port_usage_pattern[ntohs(udp_header->source)] += 1.0f;
-            features.port_usage_pattern[ntohs(udp_header->dest)] += 1.0f;
-        }
+    if (entropy_count > 0) {
+        features.avg_payload_entropy = entropy_sum / entropy_count;
     }
 
-    // 归一化端口使用模式
-    float max_port_usage = *std::max_element(features.port_usage_pattern.begin(), features.port_usage_pattern.end());
-    if (max_port_usage > 0) {
-        for (auto& usage : features.port_usage_pattern) {
-            usage /= max_port_usage;
+    // 计算端口使用模式（有界Top-K结构，归一化推迟到featuresToVector）
+    for (size_t i = 0; i < count; ++i) {
+        const auto& parsed = packets[i]->parsed;
+        if (!parsed.valid) continue;
+
+        if (parsed.protocol == IPPROTO_TCP || parsed.protocol == IPPROTO_UDP) {
+            features.port_usage_pattern.update(parsed.src_port);
+            features.port_usage_pattern.update(parsed.dst_port);
         }
     }
 
     // 计算连接模式特征
-    calculateConnectionPattern(features, packets);
+    calculateConnectionPattern(features, packets, count);
 
     return features;
 }
@@ -146,84 +160,58 @@ void FeatureExtractor::updateFeatures(FlowFeatures& features, const capture::Pac
     features.byte_count += packet.length;
 
     // 更新协议分布
-    if (packet.data.size() >= 34) {
-        struct ip* ip_header = (struct ip*)(packet.data.data() + 14);
-        if (ip_header->ip_v == 4) {
-            std::string protocol;
-            switch (ip_header->ip_p) {
-                case IPPROTO_TCP: protocol = "TCP"; break;
-                case IPPROTO_UDP: protocol = "UDP"; break;
-                case IPPROTO_ICMP: protocol = "ICMP"; break;
-                default: protocol = "OTHER";
-            }
-            features.protocol_distribution[protocol] = 
-                (features.protocol_distribution[protocol] * (features.packet_count - 1) + 1.0f) / features.packet_count;
-        }
+    if (packet.parsed.valid) {
+        const int index = protocolIndex(packet.parsed.protocol);
+        features.protocol_distribution[index] =
+            (features.protocol_distribution[index] * (features.packet_count - 1) + 1.0f) / features.packet_count;
     }
 
     // 更新其他特征...
     // 注意：某些特征（如时间特征）需要完整的包序列才能计算
 }
 
-float FeatureExtractor::calculateEntropy(const std::vector<uint8_t>& data) {
-    if (data.empty()) return 0.0f;
-
-    std::array<int, 256> freq = {0};
-    for (uint8_t byte : data) {
-        freq[byte]++;
-    }
-
-    float entropy = 0.0f;
-    float size = static_cast<float>(data.size());
-    for (int count : freq) {
-        if (count > 0) {
-            float p = count / size;
-            entropy -= p * std::log2(p);
-        }
-    }
-
-    return entropy;
+float FeatureExtractor::calculateEntropy(const uint8_t* data, size_t size) {
+    // 向量化内核：8路展开直方图 + 查找表熵计算
+    return simd::payloadEntropy(data, size);
 }
 
-void FeatureExtractor::calculateConnectionPattern(FlowFeatures& features, 
-                                                const std::vector<capture::PacketInfo>& packets) {
-    features.connection_pattern.clear();
-    features.connection_pattern.resize(10, 0.0f);  // 使用10个特征维度
-
-    std::unordered_map<std::string, int> connection_states;
-    for (const auto& packet : packets) {
-        if (packet.data.size() < 34) continue;
-
-        struct ip* ip_header = (struct ip*)(packet.data.data() + 14);
-        if (ip_header->ip_p == IPPROTO_TCP) {
-            struct tcphdr* tcp_header = (struct tcphdr*)((uint8_t*)ip_header + (ip_header->ip_hl << 2));
-            
-            // 提取连接特征
-            std::string conn_key = std::to_string(ntohl(ip_header->ip_src.s_addr)) + ":" +
-                                 std::to_string(ntohs(tcp_header->source)) + "->" +
-                                 std::to_string(ntohl(ip_header->ip_dst.s_addr)) + ":" +
-                                 std::to_string(ntohs(tcp_header->dest));
-
-            // 更新连接状态
-            connection_states[conn_key]++;
-
-            // 提取TCP标志特征
-            if (tcp_header->syn) features.connection_pattern[0]++;
-            if (tcp_header->ack) features.connection_pattern[1]++;
-            if (tcp_header->fin) features.connection_pattern[2]++;
-            if (tcp_header->rst) features.connection_pattern[3]++;
-            if (tcp_header->psh) features.connection_pattern[4]++;
-            if (tcp_header->urg) features.connection_pattern[5]++;
-        }
+void FeatureExtractor::calculateConnectionPattern(FlowFeatures& features,
+                                                const capture::PacketInfo* const* packets,
+                                                size_t count) {
+    features.connection_pattern.fill(0.0f);  // 10个特征维度
+
+    // 连接身份用打包5元组做键：无字符串格式化，哈希只混合两个64位字
+    std::unordered_map<FlowKey, int, FlowKeyHash> connection_states;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& parsed = packets[i]->parsed;
+        if (!parsed.valid || parsed.protocol != IPPROTO_TCP) continue;
+
+        // 更新连接状态
+        FlowKey conn_key;
+        conn_key.src_ip = parsed.src_ip;
+        conn_key.dst_ip = parsed.dst_ip;
+        conn_key.src_port = parsed.src_port;
+        conn_key.dst_port = parsed.dst_port;
+        conn_key.protocol = parsed.protocol;
+        conn_key.ip_version = parsed.ip_version;
+        connection_states[conn_key]++;
+
+        // 提取TCP标志特征
+        if (parsed.tcp_flags & capture::kTcpSyn) features.connection_pattern[0]++;
+        if (parsed.tcp_flags & capture::kTcpAck) features.connection_pattern[1]++;
+        if (parsed.tcp_flags & capture::kTcpFin) features.connection_pattern[2]++;
+        if (parsed.tcp_flags & capture::kTcpRst) features.connection_pattern[3]++;
+        if (parsed.tcp_flags & capture::kTcpPsh) features.connection_pattern[4]++;
+        if (parsed.tcp_flags & capture::kTcpUrg) features.connection_pattern[5]++;
     }
 
     // 计算连接模式统计
     if (!connection_states.empty()) {
         float avg_conn_packets = 0.0f;
         float max_conn_packets = 0.0f;
-        for (const auto& [_, count] : connection_states) {
-            avg_conn_packets += count;
-            max_conn_packets = std::max(max_conn_packets, static_cast<float>(count));
+        for (const auto& [_, conn_packets] : connection_states) {
+            avg_conn_packets += conn_packets;
+            max_conn_packets = std::max(max_conn_packets, static_cast<float>(conn_packets));
         }
         avg_conn_packets /= connection_states.size();
 
@@ -259,32 +247,17 @@ std::vector<float> FeatureExtractor::featuresToVector(const FlowFeatures& featur
     vector.push_back(features.mean_inter_arrival_time);
     vector.push_back(features.std_inter_arrival_time);
 
-    // 协议分布
-    std::vector<std::string> protocols = {"TCP", "UDP", "ICMP", "OTHER"};
-    for (const auto& protocol : protocols) {
-        vector.push_back(features.protocol_distribution.count(protocol) ? 
-                        features.protocol_distribution.at(protocol) : 0.0f);
-    }
+    // 协议分布（TCP/UDP/ICMP/OTHER定长布局）
+    vector.insert(vector.end(), features.protocol_distribution.begin(),
+                  features.protocol_distribution.end());
 
     // 负载熵值统计
-    if (!features.payload_entropy.empty()) {
-        float avg_entropy = std::accumulate(features.payload_entropy.begin(), 
-                                          features.payload_entropy.end(), 0.0f) / 
-                          features.payload_entropy.size();
-        float max_entropy = *std::max_element(features.payload_entropy.begin(), 
-                                            features.payload_entropy.end());
-        vector.push_back(avg_entropy);
-        vector.push_back(max_entropy);
-    } else {
-        vector.push_back(0.0f);
-        vector.push_back(0.0f);
-    }
+    vector.push_back(features.avg_payload_entropy);
+    vector.push_back(features.max_payload_entropy);
 
-    // 端口使用模式（取前20个最活跃的端口）
-    std::vector<float> sorted_ports = features.port_usage_pattern;
-    std::partial_sort(sorted_ports.begin(), sorted_ports.begin() + 20, sorted_ports.end(), 
-                     std::greater<float>());
-    vector.insert(vector.end(), sorted_ports.begin(), sorted_ports.begin() + 20);
+    // 端口使用模式（取前20个最活跃的端口，已归一化）
+    auto top_ports = features.port_usage_pattern.topCounts(20);
+    vector.insert(vector.end(), top_ports.begin(), top_ports.end());
 
     // 连接模式特征
     vector.insert(vector.end(), features.connection_pattern.begin(), features.connection_pattern.end());
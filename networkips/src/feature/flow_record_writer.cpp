@@ -0,0 +1,168 @@
+#include "feature/flow_record_writer.hpp"
+#include "common/logger.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+namespace nips {
+namespace feature {
+
+namespace {
+constexpr char kMagic[8] = {'N', 'I', 'P', 'S', 'F', 'L', 'O', 'W'};
+constexpr uint32_t kFormatVersion = 3;  // v3: ip_version启用原pad字节（布局不变）
+} // namespace
+
+FlowRecordWriter::FlowRecordWriter() = default;
+
+FlowRecordWriter::~FlowRecordWriter() {
+    close();
+}
+
+bool FlowRecordWriter::init(const std::string& export_dir, size_t segment_mb,
+                            size_t sync_interval_records) {
+    if (export_dir.empty() || segment_mb == 0) {
+        NIPS_ERROR("流记录写入器参数无效: dir='{}', segment_mb={}",
+                   export_dir, segment_mb);
+        return false;
+    }
+
+    if (mkdir(export_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        NIPS_ERROR("无法创建流记录目录 {}: {}", export_dir, strerror(errno));
+        return false;
+    }
+
+    export_dir_ = export_dir;
+    segment_bytes_ = segment_mb * 1024 * 1024;
+    sync_interval_ = sync_interval_records > 0 ? sync_interval_records : 4096;
+
+    if (!rollSegment()) {
+        return false;
+    }
+
+    NIPS_INFO("流记录写入器已初始化: 目录 {}, 段大小 {}MB, 同步间隔 {} 条",
+              export_dir_, segment_mb, sync_interval_);
+    return true;
+}
+
+bool FlowRecordWriter::rollSegment() {
+    const std::string path = export_dir_ + "/flows_" +
+        std::to_string(std::time(nullptr)) + "_" +
+        std::to_string(segment_seq_++) + ".bin";
+
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        NIPS_ERROR("无法创建流记录段 {}: {}", path, strerror(errno));
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(segment_bytes_)) != 0) {
+        NIPS_ERROR("无法预分配流记录段 {}: {}", path, strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    uint8_t* map = static_cast<uint8_t*>(mmap(nullptr, segment_bytes_,
+                                              PROT_READ | PROT_WRITE,
+                                              MAP_SHARED, fd, 0));
+    if (map == MAP_FAILED) {
+        NIPS_ERROR("无法映射流记录段 {}: {}", path, strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    FlowSegmentHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.record_size = sizeof(FlowRecord);
+    header.record_count = 0;
+    std::memcpy(map, &header, sizeof(header));
+
+    fd_ = fd;
+    map_ = map;
+    map_size_ = segment_bytes_;
+    write_offset_ = sizeof(FlowSegmentHeader);
+    segment_records_ = 0;
+    records_since_sync_ = 0;
+    return true;
+}
+
+void FlowRecordWriter::append(const FlowKey& key, const FlowFeatures& features) {
+    FlowRecord record;
+    record.src_ip = key.src_ip;
+    record.dst_ip = key.dst_ip;
+    record.src_port = key.src_port;
+    record.dst_port = key.dst_port;
+    record.protocol = key.protocol;
+    record.ip_version = key.ip_version;
+    record.export_time = static_cast<uint32_t>(std::time(nullptr));
+    record.sample_rate = features.sample_rate;
+
+    const auto vec = converter_.featuresToVector(features);
+    const size_t n = std::min(vec.size(), sizeof(record.features) / sizeof(float));
+    std::memcpy(record.features, vec.data(), n * sizeof(float));
+    if (n < sizeof(record.features) / sizeof(float)) {
+        std::memset(record.features + n, 0,
+                    (sizeof(record.features) / sizeof(float) - n) * sizeof(float));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!map_) {
+        return;
+    }
+
+    if (write_offset_ + sizeof(FlowRecord) > map_size_) {
+        // 当前段写满：落盘、截断并滚动新段
+        sync();
+        munmap(map_, map_size_);
+        (void)!ftruncate(fd_, static_cast<off_t>(write_offset_));
+        ::close(fd_);
+        map_ = nullptr;
+        fd_ = -1;
+        if (!rollSegment()) {
+            return;
+        }
+    }
+
+    std::memcpy(map_ + write_offset_, &record, sizeof(record));
+    write_offset_ += sizeof(record);
+    segment_records_++;
+    records_written_++;
+
+    if (++records_since_sync_ >= sync_interval_) {
+        sync();
+        records_since_sync_ = 0;
+    }
+}
+
+void FlowRecordWriter::sync() {
+    if (!map_) {
+        return;
+    }
+    // 先更新头部计数再msync：读取器只信任头部计数内的记录
+    auto* header = reinterpret_cast<FlowSegmentHeader*>(map_);
+    header->record_count = segment_records_;
+    msync(map_, write_offset_, MS_ASYNC);
+}
+
+void FlowRecordWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!map_) {
+        return;
+    }
+    auto* header = reinterpret_cast<FlowSegmentHeader*>(map_);
+    header->record_count = segment_records_;
+    msync(map_, write_offset_, MS_SYNC);
+    munmap(map_, map_size_);
+    (void)!ftruncate(fd_, static_cast<off_t>(write_offset_));
+    ::close(fd_);
+    map_ = nullptr;
+    fd_ = -1;
+    NIPS_INFO("流记录写入器已关闭: 共写入 {} 条记录", records_written_);
+}
+
+} // namespace feature
+} // namespace nips
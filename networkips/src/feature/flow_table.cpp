@@ -0,0 +1,291 @@
+#include "feature/flow_table.hpp"
+#include "feature/simd_kernels.hpp"
+#include "common/logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace nips {
+namespace feature {
+
+FlowTable::FlowTable() = default;
+
+FlowTable::~FlowTable() = default;
+
+bool FlowTable::init(size_t flow_timeout_seconds, size_t max_packets_per_flow,
+                     unsigned feature_mask) {
+    if (flow_timeout_seconds == 0 || max_packets_per_flow == 0) {
+        NIPS_ERROR("流表参数无效: timeout={}, max_packets={}",
+                   flow_timeout_seconds, max_packets_per_flow);
+        return false;
+    }
+    flow_timeout_seconds_ = flow_timeout_seconds;
+    max_packets_per_flow_ = max_packets_per_flow;
+    feature_mask_ = feature_mask & kFeatAll;
+
+    // 时间轮槽数：2的幂且严格大于超时横距，
+    // 保证槽内流到期时间与游标到达时刻一致
+    uint32_t slots = 1;
+    while (slots <= flow_timeout_seconds_ + 1) {
+        slots <<= 1;
+    }
+    wheel_.assign(slots, nullptr);
+    wheel_mask_ = slots - 1;
+    wheel_time_ = 0;
+    // 所有掩码组合的累积内核实例化表；按掩码选一个，
+    // 之后热路径走固定的成员函数指针
+    static constexpr auto kAccumulateTable =
+        makeAccumulateTable(std::make_index_sequence<kFeatAll + 1>{});
+    accumulate_fn_ = kAccumulateTable[feature_mask_];
+    NIPS_INFO("流表已初始化: 超时 {}s, 每流最大包数 {}, 特征组掩码 {:#x}",
+              flow_timeout_seconds_, max_packets_per_flow_, feature_mask_);
+    return true;
+}
+
+void FlowTable::setFlowCallback(FlowCallback callback) {
+    callback_ = std::move(callback);
+}
+
+bool FlowTable::extractKey(const capture::PacketInfo& packet, FlowKey& key) {
+    // 头部已在捕获阶段解析，这里只读描述字段；
+    // IPv6流按折叠地址建键，与IPv4流走同一张表
+    const capture::ParsedPacket& parsed = packet.parsed;
+    if (!parsed.valid) {
+        return false;
+    }
+    key.src_ip = parsed.src_ip;
+    key.dst_ip = parsed.dst_ip;
+    key.src_port = parsed.src_port;
+    key.dst_port = parsed.dst_port;
+    key.protocol = parsed.protocol;
+    key.ip_version = parsed.ip_version;
+    return true;
+}
+
+void FlowTable::update(const capture::PacketInfo& packet) {
+    FlowKey key;
+    if (!extractKey(packet, key)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    FlowState*& state = flows_[key];
+    if (!state) {
+        state = state_pool_.acquire();
+        state->key = key;
+    }
+    (this->*accumulate_fn_)(*state, key, packet);
+
+    // 达到包数上限立即结算
+    if (state->features.packet_count >= max_packets_per_flow_) {
+        wheelUnlink(state);
+        emitFlow(key, *state);
+        state_pool_.release(state);
+        flows_.erase(key);
+        return;
+    }
+
+    // 每次触达O(1)重排时间轮槽位
+    wheelSchedule(state);
+}
+
+template<unsigned Mask>
+void FlowTable::accumulate(FlowState& state, const FlowKey& key,
+                           const capture::PacketInfo& packet) {
+    FlowFeatures& features = state.features;
+
+    // 时间戳与包计数无条件维护：超时结算和包数上限依赖它们
+    if (features.packet_count == 0) {
+        state.first_timestamp = packet.timestamp;
+    } else if constexpr (Mask & kFeatTimeFeatures) {
+        // 包间隔的Welford更新
+        const double iat = packet.timestamp - state.last_timestamp;
+        state.iat_count++;
+        const double delta = iat - state.iat_mean;
+        state.iat_mean += delta / state.iat_count;
+        state.iat_m2 += delta * (iat - state.iat_mean);
+    }
+    state.last_timestamp = packet.timestamp;
+
+    features.packet_count++;
+    state.stride_sum += packet.sample_stride;
+
+    if constexpr (Mask & kFeatBasicStats) {
+        features.byte_count += packet.length;
+
+        // 包大小的Welford更新
+        const double size_delta = packet.length - state.size_mean;
+        state.size_mean += size_delta / features.packet_count;
+        state.size_m2 += size_delta * (packet.length - state.size_mean);
+    }
+
+    if constexpr (Mask & kFeatProtocolDistribution) {
+        state.proto_counts[protocolIndex(key.protocol)]++;
+    }
+
+    // 负载熵运行统计（仅对有负载的包计算）
+    if constexpr (Mask & kFeatPayloadEntropy) {
+        if (packet.parsed.payload_length > 0) {
+            const float entropy = simd::payloadEntropy(
+                packet.data() + packet.parsed.payload_offset,
+                packet.parsed.payload_length);
+            state.entropy_sum += entropy;
+            state.entropy_max = std::max(state.entropy_max, entropy);
+            state.entropy_count++;
+        }
+    }
+
+    if constexpr (Mask & kFeatConnectionPattern) {
+        // 端口使用累积（有界Top-K）
+        if (key.src_port != 0 || key.dst_port != 0) {
+            features.port_usage_pattern.update(key.src_port);
+            features.port_usage_pattern.update(key.dst_port);
+        }
+
+        // TCP标志计数（connection_pattern[0..5]）
+        const uint8_t flags = packet.parsed.tcp_flags;
+        if (flags != 0) {
+            if (flags & capture::kTcpSyn) features.connection_pattern[0]++;
+            if (flags & capture::kTcpAck) features.connection_pattern[1]++;
+            if (flags & capture::kTcpFin) features.connection_pattern[2]++;
+            if (flags & capture::kTcpRst) features.connection_pattern[3]++;
+            if (flags & capture::kTcpPsh) features.connection_pattern[4]++;
+            if (flags & capture::kTcpUrg) features.connection_pattern[5]++;
+        }
+    }
+}
+
+void FlowTable::emitFlow(const FlowKey& key, FlowState& state) {
+    FlowFeatures& features = state.features;
+    if (features.packet_count == 0) {
+        return;
+    }
+
+    // 由累积器结算派生特征（结算按流发生，掩码判断在此无关紧要）
+    features.flow_key_hi = key.packHi();
+    features.flow_key_lo = key.packLo();
+    features.sample_rate = state.stride_sum > 0 ?
+        static_cast<float>(features.packet_count) / state.stride_sum : 1.0f;
+    features.duration = state.last_timestamp - state.first_timestamp;
+    features.packets_per_second = features.packet_count / (features.duration + 1e-6f);
+    features.bytes_per_second = features.byte_count / (features.duration + 1e-6f);
+
+    if (feature_mask_ & kFeatBasicStats) {
+        features.mean_packet_size = static_cast<float>(state.size_mean);
+        features.std_packet_size = features.packet_count > 0 ?
+            std::sqrt(static_cast<float>(state.size_m2 / features.packet_count)) : 0.0f;
+    }
+    if (feature_mask_ & kFeatTimeFeatures) {
+        features.mean_inter_arrival_time = static_cast<float>(state.iat_mean);
+        features.std_inter_arrival_time = state.iat_count > 0 ?
+            std::sqrt(static_cast<float>(state.iat_m2 / state.iat_count)) : 0.0f;
+    }
+
+    if (feature_mask_ & kFeatProtocolDistribution) {
+        for (int i = 0; i < kProtoCount; ++i) {
+            features.protocol_distribution[i] =
+                static_cast<float>(state.proto_counts[i]) / features.packet_count;
+        }
+    }
+
+    // 熵运行统计结算
+    if (state.entropy_count > 0) {
+        features.avg_payload_entropy = state.entropy_sum / state.entropy_count;
+        features.max_payload_entropy = state.entropy_max;
+    }
+
+    // 单流内连接模式统计（connection_pattern[6..9]）：单连接流的
+    // 连接均包数就是packet_count，归一化后[6]恒为1
+    features.connection_pattern[6] = 1.0f;
+    features.connection_pattern[7] = 1.0f;
+    features.connection_pattern[8] = 1.0f / features.packet_count;
+    features.connection_pattern[9] = 1.0f;
+
+    if (callback_) {
+        callback_(key, std::move(features));
+    }
+}
+
+void FlowTable::wheelUnlink(FlowState* state) {
+    if (state->wheel_slot == UINT32_MAX) {
+        return;
+    }
+    if (state->wheel_prev) {
+        state->wheel_prev->wheel_next = state->wheel_next;
+    } else {
+        wheel_[state->wheel_slot] = state->wheel_next;
+    }
+    if (state->wheel_next) {
+        state->wheel_next->wheel_prev = state->wheel_prev;
+    }
+    state->wheel_prev = nullptr;
+    state->wheel_next = nullptr;
+    state->wheel_slot = UINT32_MAX;
+}
+
+void FlowTable::wheelSchedule(FlowState* state) {
+    const uint32_t slot =
+        (state->last_timestamp + static_cast<uint32_t>(flow_timeout_seconds_)) & wheel_mask_;
+    if (slot == state->wheel_slot) {
+        return;  // 同一秒内的后续包不需要移动
+    }
+    wheelUnlink(state);
+    state->wheel_slot = slot;
+    state->wheel_next = wheel_[slot];
+    if (wheel_[slot]) {
+        wheel_[slot]->wheel_prev = state;
+    }
+    wheel_[slot] = state;
+}
+
+void FlowTable::checkTimeouts(uint32_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (wheel_time_ == 0) {
+        // 首次调用只校准游标，避免冷启动时扫过整圈
+        wheel_time_ = now;
+        return;
+    }
+    if (now <= wheel_time_) {
+        return;
+    }
+
+    // 游标推进不超过一整圈：超过一圈时所有槽都已被扫过一遍
+    const uint32_t steps = std::min<uint32_t>(now - wheel_time_, wheel_mask_ + 1);
+    for (uint32_t i = 1; i <= steps; ++i) {
+        FlowState* state = wheel_[(wheel_time_ + i) & wheel_mask_];
+        while (state) {
+            FlowState* next = state->wheel_next;
+            // 槽内流在游标到达时恰好到期；触达过的流已被移走，
+            // 此处校验只防御时钟回跳
+            if (now - state->last_timestamp >= flow_timeout_seconds_) {
+                wheelUnlink(state);
+                emitFlow(state->key, *state);
+                flows_.erase(state->key);
+                state_pool_.release(state);
+            } else {
+                wheelSchedule(state);
+            }
+            state = next;
+        }
+    }
+    wheel_time_ = now;
+}
+
+void FlowTable::flushAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [key, state] : flows_) {
+        wheelUnlink(state);
+        emitFlow(key, *state);
+        state_pool_.release(state);
+    }
+    flows_.clear();
+}
+
+size_t FlowTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flows_.size();
+}
+
+} // namespace feature
+} // namespace nips
@@ -0,0 +1,176 @@
+#include "feature/simd_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <array>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace nips {
+namespace feature {
+namespace simd {
+
+namespace {
+
+// n*log2(n) 查找表；覆盖到池块大小之上，超界时直接计算
+constexpr size_t kLogTableSize = 4096;
+
+const std::array<float, kLogTableSize>& logTable() {
+    static const std::array<float, kLogTableSize> table = []() {
+        std::array<float, kLogTableSize> t{};
+        t[0] = 0.0f;
+        for (size_t i = 1; i < kLogTableSize; ++i) {
+            t[i] = static_cast<float>(i) * std::log2(static_cast<float>(i));
+        }
+        return t;
+    }();
+    return table;
+}
+
+inline float countLog2Count(uint32_t count) {
+    const auto& table = logTable();
+    if (count < kLogTableSize) {
+        return table[count];
+    }
+    return static_cast<float>(count) * std::log2(static_cast<float>(count));
+}
+
+#ifdef __AVX2__
+// 8通道水平求和
+inline float hsum256(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_hadd_ps(lo, lo);
+    lo = _mm_hadd_ps(lo, lo);
+    return _mm_cvtss_f32(lo);
+}
+#endif
+
+} // namespace
+
+void byteHistogram(const uint8_t* data, size_t size, uint32_t freq[256]) {
+    // 8个子表：连续字节落到不同子表，消除同桶自增的依赖串行化
+    alignas(64) uint32_t sub[8][256];
+    std::memset(sub, 0, sizeof(sub));
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        sub[0][data[i + 0]]++;
+        sub[1][data[i + 1]]++;
+        sub[2][data[i + 2]]++;
+        sub[3][data[i + 3]]++;
+        sub[4][data[i + 4]]++;
+        sub[5][data[i + 5]]++;
+        sub[6][data[i + 6]]++;
+        sub[7][data[i + 7]]++;
+    }
+    for (; i < size; ++i) {
+        sub[0][data[i]]++;
+    }
+
+    // 归并子表
+#ifdef __AVX2__
+    for (int b = 0; b < 256; b += 8) {
+        __m256i acc = _mm256_setzero_si256();
+        for (int t = 0; t < 8; ++t) {
+            acc = _mm256_add_epi32(acc,
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(&sub[t][b])));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&freq[b]), acc);
+    }
+#else
+    for (int b = 0; b < 256; ++b) {
+        uint32_t total = 0;
+        for (int t = 0; t < 8; ++t) {
+            total += sub[t][b];
+        }
+        freq[b] = total;
+    }
+#endif
+}
+
+float entropyFromHistogram(const uint32_t freq[256], size_t total) {
+    if (total == 0) {
+        return 0.0f;
+    }
+
+    float sum = 0.0f;
+
+#ifdef __AVX2__
+    // 常见负载长度下count都在查找表内，gather批量取 count*log2(count)；
+    // 有超界桶时该组退回标量
+    const auto& table = logTable();
+    __m256 acc = _mm256_setzero_ps();
+    const __m256i limit = _mm256_set1_epi32(static_cast<int>(kLogTableSize));
+
+    for (int b = 0; b < 256; b += 8) {
+        __m256i counts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&freq[b]));
+        __m256i in_range = _mm256_cmpgt_epi32(limit, counts);
+        if (_mm256_movemask_epi8(in_range) == -1) {
+            acc = _mm256_add_ps(acc,
+                _mm256_i32gather_ps(table.data(), counts, sizeof(float)));
+        } else {
+            for (int j = 0; j < 8; ++j) {
+                sum += countLog2Count(freq[b + j]);
+            }
+        }
+    }
+    sum += hsum256(acc);
+#else
+    for (int b = 0; b < 256; ++b) {
+        sum += countLog2Count(freq[b]);
+    }
+#endif
+
+    const float ftotal = static_cast<float>(total);
+    return std::log2(ftotal) - sum / ftotal;
+}
+
+void meanVariance(const float* data, size_t size, float& mean, float& variance) {
+    mean = 0.0f;
+    variance = 0.0f;
+    if (size == 0) {
+        return;
+    }
+
+    float sum = 0.0f;
+    float sum_sq = 0.0f;
+    size_t i = 0;
+
+#ifdef __AVX2__
+    __m256 vsum = _mm256_setzero_ps();
+    __m256 vsum_sq = _mm256_setzero_ps();
+    for (; i + 8 <= size; i += 8) {
+        __m256 v = _mm256_loadu_ps(data + i);
+        vsum = _mm256_add_ps(vsum, v);
+        vsum_sq = _mm256_fmadd_ps(v, v, vsum_sq);
+    }
+    sum = hsum256(vsum);
+    sum_sq = hsum256(vsum_sq);
+#endif
+
+    for (; i < size; ++i) {
+        sum += data[i];
+        sum_sq += data[i] * data[i];
+    }
+
+    mean = sum / size;
+    // E[x^2] - E[x]^2；浮点误差可能导致轻微为负，截断到0
+    variance = std::max(sum_sq / size - mean * mean, 0.0f);
+}
+
+float payloadEntropy(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0.0f;
+    }
+    alignas(32) uint32_t freq[256];
+    byteHistogram(data, size, freq);
+    return entropyFromHistogram(freq, size);
+}
+
+} // namespace simd
+} // namespace feature
+} // namespace nips
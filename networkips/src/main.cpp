@@ -3,16 +3,29 @@
 #include <thread>
 #include <atomic>
 #include <csignal>
+#include <functional>
+#include <future>
+#include <ctime>
+#include <sys/stat.h>
 #include <boost/program_options.hpp>
 #include "common/config.hpp"
 #include "common/logger.hpp"
+#include "common/telemetry.hpp"
 #include "capture/packet_capture.hpp"
+#include "pipeline/analysis_pipeline.hpp"
+#include "pipeline/overload_sampler.hpp"
 #include "feature/feature_extractor.hpp"
+#include "feature/flow_record_writer.hpp"
+#include "feature/flow_table.hpp"
 #include "ml/anomaly_detector.hpp"
+#include "ml/inference_batcher.hpp"
+#include "ml/verdict_cache.hpp"
+#include "correlation/correlation_engine.hpp"
 #include "detection/threat_detector.hpp"
 #include "response/response_controller.hpp"
 
 namespace po = boost::program_options;
+using namespace nips;
 
 std::atomic<bool> g_running{true};
 
@@ -21,6 +34,22 @@ void signalHandler(int signum) {
     g_running = false;
 }
 
+// 作用域退出时执行清理动作。用于失败路径/异常兜底：回调线程
+// （捕获、分析、遥测）引用的局部对象按声明逆序析构，guard声明
+// 在被引用对象之后，保证先停线程再析构。各stop()均幂等，
+// 正常关停路径的显式stop与兜底重复执行无害
+class ScopeExit {
+public:
+    explicit ScopeExit(std::function<void()> fn) : fn_(std::move(fn)) {}
+    ~ScopeExit() { fn_(); }
+
+    ScopeExit(const ScopeExit&) = delete;
+    ScopeExit& operator=(const ScopeExit&) = delete;
+
+private:
+    std::function<void()> fn_;
+};
+
 int main(int argc, char* argv[]) {
     // 解析命令行参数
     po::options_description desc("NIPS 选项");
@@ -63,66 +92,327 @@ int main(int argc, char* argv[]) {
     signal(SIGTERM, signalHandler);
 
     try {
-        // 创建组件实例
-        auto capture = std::make_unique<capture::PacketCapture>();
-        auto extractor = std::make_unique<feature::FeatureExtractor>();
-        auto detector = std::make_unique<ml::AnomalyDetector>();
-        auto threat_detector = std::make_unique<detection::ThreatDetector>();
-        auto response = std::make_unique<response::ResponseController>();
-
-        // 初始化组件
-        auto interface = vm.count("interface") ? 
-            vm["interface"].as<std::string>() : 
-            common::Config::getInstance().get<std::string>("capture.interface");
-
-        if (!capture->init(interface)) {
+        // 取一次配置快照；所有组件初始化从快照读取类型化字段
+        auto cfg = common::Config::getInstance().snapshot();
+        const auto config_path = vm["config"].as<std::string>();
+
+        // 重量级检测组件在后台线程并行初始化：三者互不共享状态
+        //（各自重新读取同一config_path），串行只是历史偶然。
+        // libtorch首次构图与情报/策略文件解析占了启动耗时的绝大头，
+        // 把它们移出关键路径后捕获可以在百毫秒内就绪
+        auto detector_future = std::async(std::launch::async, [&cfg]() {
+            auto detector = std::make_unique<ml::AnomalyDetector>();
+            // 加载预训练模型（torchscript_int8类型失败时自动回退fp32）
+            if (!cfg->ml.model_path.empty() &&
+                !detector->loadModel(cfg->ml.model_path)) {
+                NIPS_WARN("未能加载预训练模型，使用未训练的初始权重");
+            }
+            return detector;
+        });
+        auto threat_future = std::async(std::launch::async, [&config_path]() {
+            auto threat_detector = std::make_unique<detection::ThreatDetector>();
+            return threat_detector->init(config_path) ?
+                std::move(threat_detector) :
+                std::unique_ptr<detection::ThreatDetector>();
+        });
+        auto response_future = std::async(std::launch::async, [&config_path]() {
+            auto response = std::make_unique<response::ResponseController>();
+            return response->init(config_path) ?
+                std::move(response) :
+                std::unique_ptr<response::ResponseController>();
+        });
+
+        auto capture = capture::createCaptureSource();
+
+        auto interface = vm.count("interface") ?
+            vm["interface"].as<std::string>() :
+            cfg->capture.interface;
+
+        if (!capture->init(interface, cfg->capture.filter)) {
             NIPS_ERROR("无法初始化数据包捕获器");
             return 1;
         }
 
-        if (!threat_detector->init(vm["config"].as<std::string>())) {
-            NIPS_ERROR("无法初始化威胁检测器");
+        // 初始化分析管线：数据包按流哈希分派到N个分片，
+        // 捕获线程只负责入队，完整分析在独立线程池中执行
+        auto analysis = std::make_unique<pipeline::AnalysisPipeline>();
+        if (!analysis->init(cfg->system.threads, cfg->system.queue_size)) {
+            NIPS_ERROR("无法初始化分析管线");
             return 1;
         }
 
-        if (!response->init(vm["config"].as<std::string>())) {
+        // 每个分片一张流表：逐包O(1)增量累积，流完成后才进入检测链。
+        // 同一条流的包总落在同一分片，各表互不竞争
+        const unsigned feature_mask =
+            feature::featureMaskFromNames(cfg->feature.enabled_features);
+        std::vector<std::unique_ptr<feature::FlowTable>> flow_tables;
+        for (int i = 0; i < cfg->system.threads; ++i) {
+            auto table = std::make_unique<feature::FlowTable>();
+            if (!table->init(cfg->feature.flow_timeout_seconds,
+                             cfg->feature.max_packets_per_flow, feature_mask)) {
+                NIPS_ERROR("无法初始化流表");
+                return 1;
+            }
+            flow_tables.push_back(std::move(table));
+        }
+
+        // 过载控制：队列越过高水位后切入分层采样（SYN必留，
+        // 流中段按步长保留并打标记），而不是在内核里盲丢
+        std::unique_ptr<pipeline::OverloadSampler> sampler;
+        if (cfg->system.overload_high_pct > 0) {
+            sampler = std::make_unique<pipeline::OverloadSampler>();
+            if (!sampler->init(cfg->system.overload_high_pct,
+                               cfg->system.overload_low_pct,
+                               cfg->system.overload_sample_stride,
+                               [&]() { return analysis->maxOccupancyPct(); })) {
+                NIPS_ERROR("无法初始化过载采样器");
+                return 1;
+            }
+        }
+
+        // 立即开始捕获：工作线程尚未启动，报文先在分片环里暂存
+        //（环满则丢弃计数），等检测组件就绪后由analysis->start统一排空。
+        // 这样重启的盲区只有捕获自身的初始化耗时
+        // 捕获回调只做一次入队（转移所有权），永不阻塞捕获线程
+        capture->start([&](capture::PacketInfo&& packet) {
+            if (!g_running) return;
+            if (sampler && !sampler->admit(packet)) {
+                return;
+            }
+            analysis->submit(std::move(packet));
+        });
+        NIPS_INFO("捕获已就绪（接口 {}），检测组件后台初始化中", interface);
+
+        // 捕获/分析回调按引用捕获sampler、analysis、flow_tables：
+        // 后续任一init失败（或异常）展开栈时，必须先停掉这两组
+        // 线程，否则它们会解引用已析构的对象
+        ScopeExit pipeline_guard([&]() {
+            capture->stop();
+            analysis->stop();
+        });
+
+        // 汇合后台初始化；任一失败都与原先串行路径同样处理
+        auto detector = detector_future.get();
+        auto threat_detector = threat_future.get();
+        if (!threat_detector) {
+            NIPS_ERROR("无法初始化威胁检测器");
+            return 1;
+        }
+        auto response = response_future.get();
+        if (!response) {
             NIPS_ERROR("无法初始化响应控制器");
             return 1;
         }
 
-        // 设置数据包处理回调
-        capture->start([&](const capture::PacketInfo& packet) {
+        // 清白流快路径：连续清白的长流跳过重复推理
+        std::unique_ptr<ml::VerdictCache> verdict_cache;
+        if (cfg->ml.enable_verdict_cache) {
+            verdict_cache = std::make_unique<ml::VerdictCache>();
+            if (!verdict_cache->init(cfg->ml.verdict_clean_batches,
+                                     cfg->ml.verdict_score_margin,
+                                     cfg->ml.verdict_resample_interval,
+                                     cfg->ml.verdict_max_entries)) {
+                NIPS_ERROR("无法初始化判定缓存");
+                return 1;
+            }
+        }
+
+        // 初始化批量推理：攒批做一次forward，而不是逐流单样本推理
+        auto batcher = std::make_unique<ml::InferenceBatcher>(*detector);
+        if (!batcher->init(cfg->ml.batch_size, cfg->ml.max_batch_delay_ms)) {
+            NIPS_ERROR("无法初始化批量推理调度器");
+            return 1;
+        }
+
+        // 批量推理结果回调：对每个流运行威胁检测链
+        batcher->start([&](feature::FlowFeatures&& features,
+                           const ml::DetectionResult& anomaly_result) {
             if (!g_running) return;
 
-            try {
-                // 提取特征
-                auto features = extractor->extractFeatures({packet});
-                
-                // 检测异常
-                auto anomaly_result = detector->detect(features);
-                
-                // 检测威胁
-                auto threat = threat_detector->detectThreat(features, anomaly_result);
-                
-                // 处理威胁
-                if (threat.level != detection::ThreatLevel::NONE) {
-                    auto action = response->handleThreat(threat);
-                    response->executeAction(action);
-                }
-            } catch (const std::exception& e) {
-                NIPS_ERROR("处理数据包时发生错误: {}", e.what());
+            // 判定结果回填快路径缓存
+            if (verdict_cache) {
+                verdict_cache->recordResult(features, anomaly_result);
+            }
+
+            // 检测威胁
+            detection::ThreatInfo threat;
+            {
+                common::Telemetry::ScopedTimer timer(common::kStageThreatDetect);
+                threat = threat_detector->detectThreat(features, anomaly_result);
             }
+
+            // 处理威胁
+            if (threat.level != detection::ThreatLevel::NONE) {
+                common::Telemetry::ScopedTimer timer(common::kStageResponse);
+                auto action = response->handleThreat(threat);
+                response->executeAction(action);
+            }
+        });
+
+        // 跨流关联：滑动窗口计数器捕捉portscan/sweep这类
+        // 单流视角看不见的模式；告警走与威胁检测相同的响应链
+        std::unique_ptr<correlation::CorrelationEngine> correlator;
+        if (cfg->detection.enable_correlation) {
+            correlator = std::make_unique<correlation::CorrelationEngine>();
+            if (!correlator->init()) {
+                NIPS_ERROR("无法初始化关联引擎");
+                return 1;
+            }
+            correlator->setAlertCallback([&](const detection::ThreatInfo& threat) {
+                if (!g_running) return;
+                common::Telemetry::ScopedTimer timer(common::kStageResponse);
+                auto action = response->handleThreat(threat);
+                response->executeAction(action);
+            });
+        }
+
+        // 可选的二进制流记录导出（离线训练数据）
+        std::unique_ptr<feature::FlowRecordWriter> record_writer;
+        if (!cfg->feature.export_dir.empty()) {
+            record_writer = std::make_unique<feature::FlowRecordWriter>();
+            if (!record_writer->init(cfg->feature.export_dir,
+                                     cfg->feature.export_segment_mb)) {
+                NIPS_WARN("流记录导出不可用，继续运行");
+                record_writer.reset();
+            }
+        }
+
+        // 流完成回调：写导出记录（如启用）并送入批量推理队列
+        for (auto& table : flow_tables) {
+            table->setFlowCallback([&](const feature::FlowKey& key,
+                                       feature::FlowFeatures&& features) {
+                if (!g_running) return;
+                if (record_writer) {
+                    record_writer->append(key, features);
+                }
+                if (correlator) {
+                    correlator->observe(features);
+                }
+                // 快路径命中的清白流直接跳过推理队列
+                if (verdict_cache && verdict_cache->shouldSkip(features)) {
+                    return;
+                }
+                batcher->submit(std::move(features));
+            });
+        }
+
+        // 分析线程按分片号更新对应流表，并排空捕获启动以来
+        // 暂存在环里的报文；偷来的任务也带原分片号
+        analysis->start([&](size_t shard, const capture::PacketInfo& packet) {
+            if (!g_running) return;
+            common::Telemetry::ScopedTimer timer(common::kStageFlowUpdate);
+            flow_tables[shard]->update(packet);
+        });
+
+        // 遥测仪表：采集时求值，不在热路径上。仪表闭包引用下文
+        // 各局部组件，异常展开时同样要先停导出线程
+        auto& telemetry = common::Telemetry::getInstance();
+        ScopeExit exporter_guard([&]() { telemetry.stopExporter(); });
+        telemetry.registerGauge("nips_capture_kernel_drops_total",
+            [&]() { return capture->kernelDrops(); });
+        telemetry.registerGauge("nips_flow_table_active_flows", [&]() {
+            uint64_t total = 0;
+            for (const auto& table : flow_tables) total += table->size();
+            return total;
+        });
+        telemetry.registerGauge("nips_analysis_queue_occupancy", [&]() {
+            uint64_t total = 0;
+            for (const auto& stats : analysis->getStats()) total += stats.occupancy;
+            return total;
         });
+        telemetry.registerGauge("nips_analysis_queue_dropped_total", [&]() {
+            uint64_t total = 0;
+            for (const auto& stats : analysis->getStats()) total += stats.dropped;
+            return total;
+        });
+        if (verdict_cache) {
+            telemetry.registerGauge("nips_verdict_cache_skipped_total",
+                [&]() { return verdict_cache->skipped(); });
+            telemetry.registerGauge("nips_verdict_cache_entries",
+                [&]() { return verdict_cache->size(); });
+        }
+        telemetry.registerGauge("nips_export_published_total",
+            [&]() { return response->exportedRecords(); });
+        if (sampler) {
+            telemetry.registerGauge("nips_overload_sampled_out_total",
+                [&]() { return sampler->sampledOut(); });
+            telemetry.registerGauge("nips_overload_sampling_active",
+                [&]() { return sampler->active() ? 1 : 0; });
+        }
+        telemetry.startExporter(static_cast<uint16_t>(cfg->system.metrics_port));
 
         NIPS_INFO("NIPS 服务已启动，正在监控接口 {}", interface);
 
-        // 主循环
+        // 模型热替换监视：记录当前模型文件的mtime，
+        // 文件被替换（夜间重训后scp覆盖）即触发影子加载+原子换入
+        time_t model_mtime = 0;
+        {
+            struct stat st;
+            if (!cfg->ml.model_path.empty() &&
+                ::stat(cfg->ml.model_path.c_str(), &st) == 0) {
+                model_mtime = st.st_mtime;
+            }
+        }
+
+        // 主循环：周期性输出队列水位，用于环大小调优
+        const int check_interval = cfg->system.check_interval;
+        int seconds_since_check = 0;
         while (g_running) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
+
+            // 每秒结算一次超时的流
+            const auto now = static_cast<uint32_t>(std::time(nullptr));
+            for (auto& table : flow_tables) {
+                table->checkTimeouts(now);
+            }
+
+            if (++seconds_since_check >= check_interval) {
+                seconds_since_check = 0;
+                if (correlator) {
+                    correlator->advance(now);
+                }
+
+                // 模型文件更新检查：失败时现役模型不受影响，下次mtime
+                // 再变时重试（覆盖scp中途读到半个文件的情况）
+                if (!cfg->ml.model_path.empty()) {
+                    struct stat st;
+                    if (::stat(cfg->ml.model_path.c_str(), &st) == 0 &&
+                        st.st_mtime != model_mtime) {
+                        model_mtime = st.st_mtime;
+                        NIPS_INFO("检测到模型文件更新，开始热加载: {}",
+                                  cfg->ml.model_path);
+                        if (!detector->loadModel(cfg->ml.model_path)) {
+                            NIPS_WARN("模型热加载失败，继续使用现役模型");
+                        }
+                    }
+                }
+
+                size_t worker_id = 0;
+                for (const auto& stats : analysis->getStats()) {
+                    NIPS_INFO("分析队列[{}]: 入队={} 出队={} 窃取={} 丢弃={} 占用={}/{}",
+                              worker_id++, stats.enqueued, stats.dequeued,
+                              stats.stolen, stats.dropped, stats.occupancy,
+                              stats.capacity);
+                }
+                size_t active_flows = 0;
+                for (const auto& table : flow_tables) {
+                    active_flows += table->size();
+                }
+                NIPS_INFO("活动流数: {}", active_flows);
+            }
         }
 
-        // 清理
+        // 清理：先停遥测端点（仪表引用各组件），再停捕获与管线
+        telemetry.stopExporter();
         capture->stop();
+        analysis->stop();
+        for (auto& table : flow_tables) {
+            table->flushAll();
+        }
+        batcher->stop();
+        if (record_writer) {
+            record_writer->close();
+        }
         NIPS_INFO("NIPS 服务已停止");
 
     } catch (const std::exception& e) {
@@ -0,0 +1,351 @@
+#include "ml/anomaly_detector.hpp"
+#include "common/config.hpp"
+#include "common/logger.hpp"
+#include <memory>
+#include <torch/torch.h>
+#include <torch/script.h>
+#ifdef USE_CUDA
+#include <c10/cuda/CUDAStream.h>
+#include <c10/cuda/CUDAGuard.h>
+#include <ATen/cuda/CUDAEvent.h>
+#endif
+
+namespace nips {
+namespace ml {
+
+// 深度学习模型：50维特征 -> 3层MLP -> 异常概率
+AnomalyDetector::DeepModel::DeepModel() {
+    const int64_t input_dim = feature::FeatureExtractor::getFeatureDimension();
+    fc1 = register_module("fc1", torch::nn::Linear(input_dim, 128));
+    fc2 = register_module("fc2", torch::nn::Linear(128, 64));
+    fc3 = register_module("fc3", torch::nn::Linear(64, 1));
+    dropout = register_module("dropout", torch::nn::Dropout(0.3));
+}
+
+torch::Tensor AnomalyDetector::DeepModel::forward(torch::Tensor x) {
+    x = torch::relu(fc1->forward(x));
+    x = dropout->forward(x);
+    x = torch::relu(fc2->forward(x));
+    x = dropout->forward(x);
+    return torch::sigmoid(fc3->forward(x));
+}
+
+class AnomalyDetector::Impl {
+public:
+    // 当前服役的模型：scripted/eager二选一打包，整体经原子
+    // shared_ptr换入换出（RCU式，与Config/IntelIndex同一模式）。
+    // 在途的detectBatch持有旧包直到返回，新批次拿到新包
+    struct ModelBundle {
+        std::shared_ptr<DeepModel> eager;
+        torch::jit::script::Module scripted;
+        bool is_scripted = false;
+    };
+
+    Impl(ModelType type) : type_(type) {
+        auto cfg = common::Config::getInstance().snapshot();
+        threshold_ = cfg->ml.anomaly_threshold;
+
+        // ml.model_type == "torchscript_int8"：加载训练侧导出的
+        // 动态量化TorchScript模型。量化算子只有CPU实现，
+        // 无GPU的边缘传感器上单批推理可快3-4倍且省4倍模型内存
+        prefer_scripted_ = (cfg->ml.model_type == "torchscript_int8");
+
+        // 限制libtorch intra-op线程数，防止其线程池铺满整机、
+        // 把推理算子调度到分析CPU集之外的节点上
+        if (cfg->system.torch_threads > 0) {
+            torch::set_num_threads(cfg->system.torch_threads);
+            NIPS_INFO("libtorch intra-op线程数限制为 {}", cfg->system.torch_threads);
+        }
+
+        if (!prefer_scripted_ && cfg->ml.enable_gpu && torch::cuda::is_available()) {
+            device_ = torch::Device(torch::kCUDA);
+            NIPS_INFO("异常检测器使用GPU推理");
+        }
+
+        auto bundle = std::make_shared<ModelBundle>();
+        bundle->eager = std::make_shared<DeepModel>();
+        bundle->eager->to(device_);
+        bundle->eager->eval();
+        std::atomic_store_explicit(&active_, std::move(bundle),
+                                   std::memory_order_release);
+    }
+
+    std::shared_ptr<ModelBundle> activeBundle() const {
+        return std::atomic_load_explicit(&active_, std::memory_order_acquire);
+    }
+
+    // 影子模型预热后原子换入；失败时现役模型不受影响
+    void swapIn(std::shared_ptr<ModelBundle> bundle) {
+        warmup(*bundle);
+        std::atomic_store_explicit(&active_, std::move(bundle),
+                                   std::memory_order_release);
+    }
+
+    // 预热前向：触发惰性初始化与JIT优化，全部发生在热路径之外
+    void warmup(ModelBundle& bundle) {
+        torch::NoGradGuard no_grad;
+        const int64_t dim = feature::FeatureExtractor::getFeatureDimension();
+        for (int i = 0; i < 3; ++i) {
+            auto dummy = torch::zeros({8, dim});
+            if (bundle.is_scripted) {
+                bundle.scripted.forward({dummy});
+            } else {
+                bundle.eager->forward(dummy.to(device_));
+            }
+        }
+    }
+
+    // 把特征向量批转换为 (N x dim) 张量
+    torch::Tensor toTensor(const std::vector<feature::FlowFeatures>& features) {
+        const int64_t dim = feature::FeatureExtractor::getFeatureDimension();
+        auto tensor = torch::empty({static_cast<int64_t>(features.size()), dim});
+        fillTensor(features, 0, features.size(), tensor);
+        return tensor;
+    }
+
+    // 把[offset, offset+count)的特征向量聚集进目标张量前count行。
+    // GPU路径用它直接填充钉页暂存缓冲，省掉一次可分页内存中转
+    void fillTensor(const std::vector<feature::FlowFeatures>& features,
+                    size_t offset, size_t count, torch::Tensor& tensor) {
+        const int64_t dim = feature::FeatureExtractor::getFeatureDimension();
+        auto accessor = tensor.accessor<float, 2>();
+        for (size_t i = 0; i < count; ++i) {
+            auto vec = converter_.featuresToVector(features[offset + i]);
+            for (int64_t j = 0; j < dim; ++j) {
+                accessor[i][j] = j < static_cast<int64_t>(vec.size()) ? vec[j] : 0.0f;
+            }
+        }
+    }
+
+#ifdef USE_CUDA
+    // GPU批推理：双缓冲钉页暂存 + 独立拷贝/计算流。
+    // 批被切成两半轮转：上一半在计算流上forward时，
+    // 下一半的H2D拷贝已在拷贝流上进行，传输与计算重叠
+    std::vector<DetectionResult> detectBatchGpu(
+        const std::shared_ptr<DeepModel>& model,
+        const std::vector<feature::FlowFeatures>& features) {
+        const int64_t dim = feature::FeatureExtractor::getFeatureDimension();
+        const size_t total = features.size();
+        const size_t chunk = (total + 1) / 2;
+
+        // 按需扩容钉页暂存缓冲（host端，cudaHostAlloc内存）
+        for (int i = 0; i < 2; ++i) {
+            if (!pinned_[i].defined() || pinned_[i].size(0) < static_cast<int64_t>(chunk)) {
+                pinned_[i] = torch::empty({static_cast<int64_t>(chunk), dim},
+                    torch::TensorOptions().dtype(torch::kFloat32).pinned_memory(true));
+            }
+        }
+        if (!copy_stream_) {
+            copy_stream_ = std::make_unique<at::cuda::CUDAStream>(
+                at::cuda::getStreamFromPool(/*isHighPriority=*/false));
+            compute_stream_ = std::make_unique<at::cuda::CUDAStream>(
+                at::cuda::getStreamFromPool(/*isHighPriority=*/true));
+        }
+
+        // 块k的H2D在拷贝流上排队并记录事件；计算流只在事件上等待，
+        // 因此块1的传输与块0的forward真正并行
+        const size_t counts[2] = {chunk, total - chunk};
+        torch::Tensor device_chunks[2];
+        at::cuda::CUDAEvent copied[2];
+
+        size_t offset = 0;
+        for (int k = 0; k < 2 && counts[k] > 0; ++k) {
+            auto staging = pinned_[k].narrow(0, 0, counts[k]);
+            fillTensor(features, offset, counts[k], staging);
+            at::cuda::CUDAStreamGuard guard(*copy_stream_);
+            device_chunks[k] = staging.to(device_, /*non_blocking=*/true);
+            copied[k].record(*copy_stream_);
+            offset += counts[k];
+        }
+
+        std::vector<torch::Tensor> outputs;
+        {
+            at::cuda::CUDAStreamGuard guard(*compute_stream_);
+            for (int k = 0; k < 2 && counts[k] > 0; ++k) {
+                copied[k].block(*compute_stream_);
+                outputs.push_back(model->forward(device_chunks[k]));
+            }
+        }
+
+        compute_stream_->synchronize();
+        auto output = torch::cat(outputs, 0).to(torch::kCPU).contiguous();
+        std::vector<DetectionResult> results;
+        results.reserve(total);
+        const float* scores = output.data_ptr<float>();
+        for (size_t i = 0; i < total; ++i) {
+            results.push_back(toResult(scores[i]));
+        }
+        return results;
+    }
+#endif
+
+    DetectionResult toResult(float score) const {
+        DetectionResult result;
+        result.anomaly_score = score;
+        result.is_anomaly = score >= threshold_;
+        // 置信度：与阈值的距离归一化
+        result.confidence = result.is_anomaly ?
+            (score - threshold_) / (1.0f - threshold_ + 1e-6f) :
+            (threshold_ - score) / (threshold_ + 1e-6f);
+        return result;
+    }
+
+    ModelType type_;
+    std::shared_ptr<ModelBundle> active_;
+    bool prefer_scripted_ = false;
+    torch::Device device_{torch::kCPU};
+    float threshold_ = 0.85f;
+    feature::FeatureExtractor converter_;
+
+#ifdef USE_CUDA
+    // GPU双缓冲状态：钉页暂存 + 专用拷贝/计算流（懒初始化）
+    torch::Tensor pinned_[2];
+    std::unique_ptr<at::cuda::CUDAStream> copy_stream_;
+    std::unique_ptr<at::cuda::CUDAStream> compute_stream_;
+#endif
+};
+
+AnomalyDetector::AnomalyDetector(ModelType type)
+    : pimpl_(std::make_unique<Impl>(type)) {
+    NIPS_INFO("异常检测器已初始化");
+}
+
+AnomalyDetector::~AnomalyDetector() = default;
+
+bool AnomalyDetector::loadModel(const std::string& model_path) {
+    // 热替换：权重先载入影子包并预热，成功后才原子换入。
+    // 任何失败路径都不触碰现役模型，运行时调用是安全的
+    auto bundle = std::make_shared<Impl::ModelBundle>();
+    if (pimpl_->prefer_scripted_) {
+        try {
+            bundle->scripted = torch::jit::load(model_path, torch::kCPU);
+            bundle->scripted.eval();
+            bundle->is_scripted = true;
+            pimpl_->swapIn(std::move(bundle));
+            NIPS_INFO("TorchScript int8模型已加载: {}", model_path);
+            return true;
+        } catch (const std::exception& e) {
+            NIPS_WARN("无法加载TorchScript模型 {}: {}，回退到fp32 eager模型",
+                      model_path, e.what());
+            bundle = std::make_shared<Impl::ModelBundle>();
+            // 继续尝试按fp32 eager格式加载
+        }
+    }
+    try {
+        bundle->eager = std::make_shared<DeepModel>();
+        torch::load(bundle->eager, model_path);
+        bundle->eager->to(pimpl_->device_);
+        bundle->eager->eval();
+        pimpl_->swapIn(std::move(bundle));
+        NIPS_INFO("模型已加载: {}", model_path);
+        return true;
+    } catch (const std::exception& e) {
+        NIPS_ERROR("无法加载模型 {}: {}", model_path, e.what());
+        return false;
+    }
+}
+
+bool AnomalyDetector::saveModel(const std::string& model_path) {
+    auto bundle = pimpl_->activeBundle();
+    if (bundle->is_scripted) {
+        NIPS_ERROR("TorchScript int8模型是推理专用产物，不支持保存");
+        return false;
+    }
+    try {
+        torch::save(bundle->eager, model_path);
+        return true;
+    } catch (const std::exception& e) {
+        NIPS_ERROR("无法保存模型 {}: {}", model_path, e.what());
+        return false;
+    }
+}
+
+DetectionResult AnomalyDetector::detect(const feature::FlowFeatures& features) {
+    // 单样本路径仅作兼容保留；热路径应走detectBatch
+    std::vector<feature::FlowFeatures> batch;
+    batch.push_back(features);
+    return detectBatch(batch).front();
+}
+
+std::vector<DetectionResult> AnomalyDetector::detectBatch(
+    const std::vector<feature::FlowFeatures>& features) {
+    std::vector<DetectionResult> results;
+    if (features.empty()) {
+        return results;
+    }
+
+    torch::NoGradGuard no_grad;
+
+    // 整批用同一个模型包；换入新模型不影响在途批次
+    auto bundle = pimpl_->activeBundle();
+
+#ifdef USE_CUDA
+    if (!bundle->is_scripted && pimpl_->device_.is_cuda()) {
+        return pimpl_->detectBatchGpu(bundle->eager, features);
+    }
+#endif
+
+    torch::Tensor output;
+    if (bundle->is_scripted) {
+        // 量化TorchScript路径：始终在CPU上执行
+        auto input = pimpl_->toTensor(features);
+        output = bundle->scripted.forward({input}).toTensor().contiguous();
+    } else {
+        auto input = pimpl_->toTensor(features).to(pimpl_->device_);
+        output = bundle->eager->forward(input).to(torch::kCPU).contiguous();
+    }
+
+    // 把批结果散回各样本
+    results.reserve(features.size());
+    const float* scores = output.data_ptr<float>();
+    for (size_t i = 0; i < features.size(); ++i) {
+        results.push_back(pimpl_->toResult(scores[i]));
+    }
+    return results;
+}
+
+void AnomalyDetector::train(const std::vector<feature::FlowFeatures>& features,
+                            const std::vector<bool>& labels,
+                            const std::string& model_path) {
+    if (features.empty() || features.size() != labels.size()) {
+        NIPS_ERROR("训练数据无效: {} 样本, {} 标签", features.size(), labels.size());
+        return;
+    }
+    auto bundle = pimpl_->activeBundle();
+    if (bundle->is_scripted) {
+        // 量化模型是推理专用产物；重训练走训练侧脚本重新导出
+        NIPS_WARN("TorchScript int8模型不支持在线训练，已忽略");
+        return;
+    }
+    auto model = bundle->eager;
+
+    auto input = pimpl_->toTensor(features).to(pimpl_->device_);
+    auto target = torch::empty({static_cast<int64_t>(labels.size()), 1});
+    for (size_t i = 0; i < labels.size(); ++i) {
+        target[i][0] = labels[i] ? 1.0f : 0.0f;
+    }
+    target = target.to(pimpl_->device_);
+
+    model->train();
+    torch::optim::Adam optimizer(model->parameters(),
+                                 torch::optim::AdamOptions(1e-3));
+    for (int epoch = 0; epoch < 10; ++epoch) {
+        optimizer.zero_grad();
+        auto output = model->forward(input);
+        auto loss = torch::binary_cross_entropy(output, target);
+        loss.backward();
+        optimizer.step();
+    }
+    model->eval();
+
+    if (!model_path.empty()) {
+        saveModel(model_path);
+    }
+}
+
+void AnomalyDetector::update(const feature::FlowFeatures& features, bool is_anomaly) {
+    train({features}, {is_anomaly});
+}
+
+} // namespace ml
+} // namespace nips
@@ -0,0 +1,106 @@
+#include "ml/inference_batcher.hpp"
+#include "common/logger.hpp"
+#include "common/telemetry.hpp"
+
+namespace nips {
+namespace ml {
+
+InferenceBatcher::InferenceBatcher(AnomalyDetector& detector)
+    : detector_(detector) {}
+
+InferenceBatcher::~InferenceBatcher() {
+    stop();
+}
+
+bool InferenceBatcher::init(size_t batch_size, uint32_t max_delay_ms) {
+    if (batch_size == 0) {
+        NIPS_ERROR("批量推理参数无效: batch_size={}", batch_size);
+        return false;
+    }
+    batch_size_ = batch_size;
+    max_delay_ = std::chrono::milliseconds(max_delay_ms);
+    NIPS_INFO("批量推理调度器已初始化: 批大小 {}, 最大延迟 {}ms",
+              batch_size_, max_delay_ms);
+    return true;
+}
+
+bool InferenceBatcher::start(ResultCallback callback) {
+    if (running_) {
+        return false;
+    }
+    callback_ = std::move(callback);
+    running_ = true;
+    flush_thread_ = std::make_unique<std::thread>([this]() { flushLoop(); });
+    return true;
+}
+
+void InferenceBatcher::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    cv_.notify_all();
+    if (flush_thread_ && flush_thread_->joinable()) {
+        flush_thread_->join();
+    }
+    flush_thread_.reset();
+
+    // 处理残留样本
+    std::vector<feature::FlowFeatures> remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        remaining.swap(pending_);
+    }
+    if (!remaining.empty()) {
+        flushBatch(std::move(remaining));
+    }
+}
+
+void InferenceBatcher::submit(feature::FlowFeatures&& features) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(features));
+        if (pending_.size() < batch_size_) {
+            return;
+        }
+    }
+    cv_.notify_one();
+}
+
+void InferenceBatcher::flushLoop() {
+    while (running_) {
+        std::vector<feature::FlowFeatures> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // 满批立即刷，否则等到最大延迟后刷掉已有样本
+            cv_.wait_for(lock, max_delay_, [this]() {
+                return !running_ || pending_.size() >= batch_size_;
+            });
+            if (pending_.empty()) {
+                continue;
+            }
+            batch.swap(pending_);
+        }
+        flushBatch(std::move(batch));
+    }
+}
+
+void InferenceBatcher::flushBatch(std::vector<feature::FlowFeatures>&& batch) {
+    try {
+        std::vector<DetectionResult> results;
+        {
+            // 一次forward覆盖整批，事件数记为批大小
+            common::Telemetry::ScopedTimer timer(common::kStageInference,
+                                                 batch.size());
+            results = detector_.detectBatch(batch);
+        }
+        for (size_t i = 0; i < results.size(); ++i) {
+            callback_(std::move(batch[i]), results[i]);
+        }
+    } catch (const std::exception& e) {
+        NIPS_ERROR("批量推理失败 ({} 样本): {}", batch.size(), e.what());
+    }
+}
+
+} // namespace ml
+} // namespace nips
@@ -0,0 +1,176 @@
+#include "ml/verdict_cache.hpp"
+#include "common/config.hpp"
+#include "common/logger.hpp"
+#include "feature/flow_key.hpp"
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace nips {
+namespace ml {
+
+namespace {
+
+// 行为漂移失效阈值：平均负载熵偏离基线超过1 bit，
+// 或SYN包占比偏离超过0.2，都视为流行为已变
+constexpr float kEntropyDrift = 1.0f;
+constexpr float kSynRatioDrift = 0.2f;
+
+using PackedKey = std::pair<uint64_t, uint64_t>;
+
+struct PackedKeyHash {
+    size_t operator()(const PackedKey& key) const {
+        return static_cast<size_t>(
+            feature::FlowKeyHash::mix(key.first ^ feature::FlowKeyHash::mix(key.second)));
+    }
+};
+
+float synRatio(const feature::FlowFeatures& features) {
+    return features.packet_count > 0 ?
+        features.connection_pattern[0] / features.packet_count : 0.0f;
+}
+
+} // namespace
+
+class VerdictCache::Impl {
+public:
+    bool init(size_t clean_batches, float score_margin,
+              size_t resample_interval, size_t max_entries) {
+        if (clean_batches == 0 || resample_interval == 0 || max_entries == 0 ||
+            score_margin < 0.0f) {
+            NIPS_ERROR("判定缓存参数无效: clean_batches={}, margin={}, "
+                       "resample={}, max_entries={}",
+                       clean_batches, score_margin, resample_interval, max_entries);
+            return false;
+        }
+        auto cfg = common::Config::getInstance().snapshot();
+        clean_score_ = cfg->ml.anomaly_threshold - score_margin;
+        clean_batches_ = clean_batches;
+        resample_interval_ = resample_interval;
+        max_entries_ = max_entries;
+        NIPS_INFO("判定缓存已初始化: 清白分数 <{:.2f}, 连续 {} 次入快路径, "
+                  "重采样间隔 {}, 容量 {}",
+                  clean_score_, clean_batches_, resample_interval_, max_entries_);
+        return true;
+    }
+
+    bool shouldSkip(const feature::FlowFeatures& features) {
+        if (features.flow_key_hi == 0 && features.flow_key_lo == 0) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find({features.flow_key_hi, features.flow_key_lo});
+        if (it == entries_.end() || !it->second.fastpath) {
+            return false;
+        }
+        Entry& entry = it->second;
+
+        // 行为漂移：立即失效并走完整推理
+        if (std::fabs(features.avg_payload_entropy - entry.entropy_baseline) > kEntropyDrift ||
+            std::fabs(synRatio(features) - entry.syn_ratio_baseline) > kSynRatioDrift) {
+            entries_.erase(it);
+            return false;
+        }
+
+        // 周期性重采样：快路径流也要定期被模型重新看一眼
+        if (++entry.skips_since_sample >= resample_interval_) {
+            entry.skips_since_sample = 0;
+            return false;
+        }
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void recordResult(const feature::FlowFeatures& features,
+                      const DetectionResult& result) {
+        if (features.flow_key_hi == 0 && features.flow_key_lo == 0) {
+            return;
+        }
+        const bool clean = !result.is_anomaly && result.anomaly_score < clean_score_;
+        std::lock_guard<std::mutex> lock(mutex_);
+        const PackedKey key{features.flow_key_hi, features.flow_key_lo};
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            if (!clean) {
+                return;  // 不清白的流不值得占缓存位
+            }
+            // 容量满时整体清空：缓存由长命流主导，很快重建；
+            // 比维护LRU链在热路径上便宜得多
+            if (entries_.size() >= max_entries_) {
+                NIPS_WARN("判定缓存达到容量上限 {}，整体清空重建", max_entries_);
+                entries_.clear();
+            }
+            it = entries_.emplace(key, Entry{}).first;
+        }
+        Entry& entry = it->second;
+
+        if (!clean) {
+            entry.fastpath = false;
+            entry.clean_streak = 0;
+            return;
+        }
+        if (!entry.fastpath && ++entry.clean_streak >= clean_batches_) {
+            // 进入快路径时记下行为基线，漂移判据以此为参照
+            entry.fastpath = true;
+            entry.skips_since_sample = 0;
+            entry.entropy_baseline = features.avg_payload_entropy;
+            entry.syn_ratio_baseline = synRatio(features);
+        }
+    }
+
+    uint64_t skipped() const {
+        return skipped_.load(std::memory_order_relaxed);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+private:
+    struct Entry {
+        uint32_t clean_streak = 0;
+        uint32_t skips_since_sample = 0;
+        bool fastpath = false;
+        float entropy_baseline = 0.0f;
+        float syn_ratio_baseline = 0.0f;
+    };
+
+    std::unordered_map<PackedKey, Entry, PackedKeyHash> entries_;
+    mutable std::mutex mutex_;
+    std::atomic<uint64_t> skipped_{0};
+    float clean_score_ = 0.65f;
+    size_t clean_batches_ = 3;
+    size_t resample_interval_ = 16;
+    size_t max_entries_ = 100000;
+};
+
+VerdictCache::VerdictCache() : pimpl_(std::make_unique<Impl>()) {}
+
+VerdictCache::~VerdictCache() = default;
+
+bool VerdictCache::init(size_t clean_batches, float score_margin,
+                        size_t resample_interval, size_t max_entries) {
+    return pimpl_->init(clean_batches, score_margin, resample_interval, max_entries);
+}
+
+bool VerdictCache::shouldSkip(const feature::FlowFeatures& features) {
+    return pimpl_->shouldSkip(features);
+}
+
+void VerdictCache::recordResult(const feature::FlowFeatures& features,
+                                const DetectionResult& result) {
+    pimpl_->recordResult(features, result);
+}
+
+uint64_t VerdictCache::skipped() const {
+    return pimpl_->skipped();
+}
+
+size_t VerdictCache::size() const {
+    return pimpl_->size();
+}
+
+} // namespace ml
+} // namespace nips
@@ -0,0 +1,168 @@
+#include "pipeline/analysis_pipeline.hpp"
+#include "common/config.hpp"
+#include "common/cpu_topology.hpp"
+#include "common/logger.hpp"
+#include "feature/flow_table.hpp"
+#include <chrono>
+
+namespace nips {
+namespace pipeline {
+
+AnalysisPipeline::AnalysisPipeline() = default;
+
+AnalysisPipeline::~AnalysisPipeline() {
+    stop();
+}
+
+bool AnalysisPipeline::init(size_t num_workers, size_t queue_size) {
+    if (num_workers == 0 || queue_size == 0) {
+        NIPS_ERROR("分析管线参数无效: workers={}, queue_size={}", num_workers, queue_size);
+        return false;
+    }
+
+    workers_.clear();
+    for (size_t i = 0; i < num_workers; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->ring = std::make_unique<MpmcRing<capture::PacketInfo>>(queue_size);
+        workers_.push_back(std::move(worker));
+    }
+
+    NIPS_INFO("分析管线已初始化: {} 个分片, 每队列容量 {}",
+              num_workers, workers_.front()->ring->capacity());
+    return true;
+}
+
+bool AnalysisPipeline::start(PacketHandler handler) {
+    if (workers_.empty() || running_) {
+        return false;
+    }
+
+    handler_ = std::move(handler);
+    running_ = true;
+
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::make_unique<std::thread>(
+            [this, i]() { workerLoop(i); });
+    }
+
+    NIPS_INFO("分析管线已启动");
+    return true;
+}
+
+void AnalysisPipeline::stop() {
+    running_ = false;
+    for (auto& worker : workers_) {
+        if (worker->thread && worker->thread->joinable()) {
+            worker->thread->join();
+        }
+    }
+}
+
+size_t AnalysisPipeline::shardOf(const capture::PacketInfo& packet) const {
+    // 与内核fanout一致按5元组分片：同一条流总在同一分片，
+    // 分片内的流状态访问因此天然串行。解析失败的包落到0号分片
+    feature::FlowKey key;
+    if (!feature::FlowTable::extractKey(packet, key)) {
+        return 0;
+    }
+    return feature::FlowKeyHash{}(key) % workers_.size();
+}
+
+bool AnalysisPipeline::submit(capture::PacketInfo packet) {
+    const size_t shard = shardOf(packet);
+    Worker& worker = *workers_[shard];
+    if (!worker.ring->tryPush(std::move(packet))) {
+        return false;  // 环满，丢弃计数已在环内累加
+    }
+    worker.enqueued.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::vector<QueueStats> AnalysisPipeline::getStats() const {
+    std::vector<QueueStats> stats;
+    stats.reserve(workers_.size());
+    for (const auto& worker : workers_) {
+        stats.push_back(QueueStats{
+            worker->enqueued.load(std::memory_order_relaxed),
+            worker->dequeued.load(std::memory_order_relaxed),
+            worker->stolen.load(std::memory_order_relaxed),
+            worker->ring->dropped(),
+            worker->ring->occupancy(),
+            worker->ring->capacity()
+        });
+    }
+    return stats;
+}
+
+size_t AnalysisPipeline::maxOccupancyPct() const {
+    size_t max_pct = 0;
+    for (const auto& worker : workers_) {
+        const size_t capacity = worker->ring->capacity();
+        if (capacity == 0) {
+            continue;
+        }
+        max_pct = std::max(max_pct, worker->ring->occupancy() * 100 / capacity);
+    }
+    return max_pct;
+}
+
+void AnalysisPipeline::workerLoop(size_t index) {
+    // 每个worker绑到CPU集内的单个CPU（按下标轮转）：分片的流表页
+    // 由处理它的worker首次写入，first-touch后访存保持节点本地
+    {
+        auto cfg = common::Config::getInstance().snapshot();
+        const auto cpus = common::CpuTopology::resolveCpuSet(
+            cfg->system.analysis_cpus, cfg->capture.interface);
+        if (!cpus.empty()) {
+            common::CpuTopology::pinCurrentThread({cpus[index % cpus.size()]});
+        }
+    }
+
+    Worker& self = *workers_[index];
+    const size_t n = workers_.size();
+    capture::PacketInfo packet;
+
+    while (running_) {
+        // 优先处理自己分片的包
+        if (self.ring->tryPop(packet)) {
+            self.dequeued.fetch_add(1, std::memory_order_relaxed);
+            try {
+                handler_(index, packet);
+            } catch (const std::exception& e) {
+                NIPS_ERROR("分析数据包时发生错误: {}", e.what());
+            }
+            continue;
+        }
+
+        // 自己的队列空了：按环序扫描别的分片偷一个任务。
+        // 偷来的任务仍以受害者的分片号执行，流状态归属不变
+        bool stole = false;
+        for (size_t offset = 1; offset < n; ++offset) {
+            const size_t victim = (index + offset) % n;
+            if (workers_[victim]->ring->tryPop(packet)) {
+                workers_[victim]->dequeued.fetch_add(1, std::memory_order_relaxed);
+                self.stolen.fetch_add(1, std::memory_order_relaxed);
+                try {
+                    handler_(victim, packet);
+                } catch (const std::exception& e) {
+                    NIPS_ERROR("分析数据包时发生错误: {}", e.what());
+                }
+                stole = true;
+                break;
+            }
+        }
+
+        if (!stole) {
+            // 全部队列空时短暂休眠，避免空转烧CPU
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    // 停止前排空自己分片的残留数据包
+    while (self.ring->tryPop(packet)) {
+        self.dequeued.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace pipeline
+} // namespace nips
@@ -0,0 +1,64 @@
+#include "pipeline/overload_sampler.hpp"
+#include "common/logger.hpp"
+#include <utility>
+
+namespace nips {
+namespace pipeline {
+
+bool OverloadSampler::init(int high_watermark_pct, int low_watermark_pct,
+                           int stride, OccupancyFn occupancy) {
+    if (high_watermark_pct <= low_watermark_pct || high_watermark_pct > 100 ||
+        low_watermark_pct < 0 || stride < 2 || stride > 255 || !occupancy) {
+        NIPS_ERROR("过载采样参数无效: high={}, low={}, stride={}",
+                   high_watermark_pct, low_watermark_pct, stride);
+        return false;
+    }
+    high_pct_ = high_watermark_pct;
+    low_pct_ = low_watermark_pct;
+    stride_ = static_cast<uint32_t>(stride);
+    occupancy_ = std::move(occupancy);
+    NIPS_INFO("过载采样已启用: 水位 {}%/{}%, 流中段保留步长 {}",
+              high_pct_, low_pct_, stride_);
+    return true;
+}
+
+bool OverloadSampler::admit(capture::PacketInfo& packet) {
+    const uint64_t n = counter_.fetch_add(1, std::memory_order_relaxed);
+    if ((n & (kCheckInterval - 1)) == 0) {
+        refresh();
+    }
+    if (!sampling_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+
+    // 流起始必留：SYN包携带扫描/洪泛检测依赖的连接建立信号，
+    // 且保证新流在流表中按时出现
+    if (packet.parsed.tcp_flags & capture::kTcpSyn) {
+        return true;
+    }
+
+    // 流中段按步长保留；保留的包代表stride个原始包
+    if (n % stride_ == 0) {
+        packet.sample_stride = static_cast<uint8_t>(stride_);
+        return true;
+    }
+    sampled_out_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void OverloadSampler::refresh() {
+    const size_t occupancy = occupancy_();
+    const bool sampling = sampling_.load(std::memory_order_relaxed);
+    if (!sampling && occupancy >= static_cast<size_t>(high_pct_)) {
+        sampling_.store(true, std::memory_order_relaxed);
+        NIPS_WARN("分析队列水位 {}% 越过高水位 {}%，进入分层采样模式",
+                  occupancy, high_pct_);
+    } else if (sampling && occupancy <= static_cast<size_t>(low_pct_)) {
+        sampling_.store(false, std::memory_order_relaxed);
+        NIPS_INFO("分析队列水位 {}% 回落到低水位 {}%，退出采样模式",
+                  occupancy, low_pct_);
+    }
+}
+
+} // namespace pipeline
+} // namespace nips
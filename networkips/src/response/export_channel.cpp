@@ -0,0 +1,172 @@
+#include "response/export_channel.hpp"
+#include "common/logger.hpp"
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace nips {
+namespace response {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'I', 'P', 'S', 'E', 'X', 'P', 'T'};
+constexpr uint32_t kFormatVersion = 1;
+
+// 段头（64字节）：head为已认领的记录总数，只增不减；
+// 消费者由head定位最新数据，由槽序号判断记录是否完整
+struct ExportShmHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;        // 槽数（2的幂）
+    uint32_t pad = 0;
+    std::atomic<uint64_t> head;
+    uint8_t reserved[32] = {0};
+};
+
+static_assert(sizeof(ExportShmHeader) == 64, "段头必须为64字节");
+
+// 槽：序号 + 记录。序号编码：认领后写入中为 pos<<1|1（奇），
+// 发布完成为 (pos+1)<<1（偶）；消费者据此识别未就绪/被覆盖/撕裂
+struct ExportSlot {
+    std::atomic<uint64_t> seq;
+    ExportRecord record;
+};
+
+void copyField(char* dst, size_t cap, const std::string& src) {
+    const size_t n = std::min(cap - 1, src.size());
+    std::memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+size_t roundUpPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+} // namespace
+
+class ExportChannel::Impl {
+public:
+    ~Impl() {
+        if (map_) {
+            ::munmap(map_, map_size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool init(const std::string& shm_name, size_t capacity) {
+        if (shm_name.empty() || shm_name[0] != '/' || capacity == 0) {
+            NIPS_ERROR("导出通道参数无效: name={}, capacity={}", shm_name, capacity);
+            return false;
+        }
+        capacity_ = roundUpPow2(capacity);
+        map_size_ = sizeof(ExportShmHeader) + capacity_ * sizeof(ExportSlot);
+
+        // O_CREAT不带O_EXCL：上次运行的残留段直接复用并重置，
+        // 消费者通过head回绕感知重启
+        fd_ = ::shm_open(shm_name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd_ < 0) {
+            NIPS_ERROR("无法创建共享内存段 {}: {}", shm_name, strerror(errno));
+            return false;
+        }
+        if (::ftruncate(fd_, static_cast<off_t>(map_size_)) != 0) {
+            NIPS_ERROR("无法设置共享内存段大小 {}: {}", shm_name, strerror(errno));
+            return false;
+        }
+        void* map = ::mmap(nullptr, map_size_, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) {
+            NIPS_ERROR("无法映射共享内存段 {}: {}", shm_name, strerror(errno));
+            return false;
+        }
+        map_ = static_cast<uint8_t*>(map);
+
+        std::memset(map_, 0, map_size_);
+        header_ = reinterpret_cast<ExportShmHeader*>(map_);
+        slots_ = reinterpret_cast<ExportSlot*>(map_ + sizeof(ExportShmHeader));
+        header_->version = kFormatVersion;
+        header_->record_size = sizeof(ExportRecord);
+        header_->capacity = static_cast<uint32_t>(capacity_);
+        header_->head.store(0, std::memory_order_relaxed);
+        // magic最后写入：消费者见到magic即可认为段头字段已就绪
+        std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+
+        NIPS_INFO("共享内存导出通道已就绪: {} ({} 槽 x {} 字节)",
+                  shm_name, capacity_, sizeof(ExportSlot));
+        return true;
+    }
+
+    // 多生产者无锁发布：fetch_add认领槽位，seqlock序号界定写入窗口。
+    // 消费者落后一圈以上时该槽被覆盖，由其自行跳到head-capacity
+    void publish(const ExportRecord& record) {
+        const uint64_t pos = header_->head.fetch_add(1, std::memory_order_relaxed);
+        ExportSlot& slot = slots_[pos & (capacity_ - 1)];
+        slot.seq.store(pos << 1 | 1, std::memory_order_release);
+        std::memcpy(&slot.record, &record, sizeof(record));
+        slot.seq.store((pos + 1) << 1, std::memory_order_release);
+        published_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t published() const {
+        return published_.load(std::memory_order_relaxed);
+    }
+
+private:
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t map_size_ = 0;
+    size_t capacity_ = 0;
+    ExportShmHeader* header_ = nullptr;
+    ExportSlot* slots_ = nullptr;
+    std::atomic<uint64_t> published_{0};
+};
+
+ExportChannel::ExportChannel() : pimpl_(std::make_unique<Impl>()) {}
+
+ExportChannel::~ExportChannel() = default;
+
+bool ExportChannel::init(const std::string& shm_name, size_t capacity) {
+    return pimpl_->init(shm_name, capacity);
+}
+
+void ExportChannel::publishThreat(const detection::ThreatInfo& threat) {
+    ExportRecord record = {};
+    record.time = static_cast<uint32_t>(std::time(nullptr));
+    record.kind = kExportThreat;
+    record.code = static_cast<uint8_t>(threat.level);
+    record.src_port = threat.source_port;
+    record.dst_port = threat.destination_port;
+    record.confidence = threat.confidence;
+    copyField(record.id, sizeof(record.id), threat.id);
+    copyField(record.label, sizeof(record.label), threat.type);
+    copyField(record.source, sizeof(record.source), threat.source_ip);
+    copyField(record.destination, sizeof(record.destination),
+              threat.destination_ip);
+    copyField(record.detail, sizeof(record.detail), threat.description);
+    pimpl_->publish(record);
+}
+
+void ExportChannel::publishAction(const ResponseAction& action, bool success) {
+    ExportRecord record = {};
+    record.time = static_cast<uint32_t>(std::time(nullptr));
+    record.kind = kExportAction;
+    record.code = static_cast<uint8_t>(action.type);
+    record.success = success ? 1 : 0;
+    copyField(record.source, sizeof(record.source), action.target);
+    copyField(record.detail, sizeof(record.detail), action.reason);
+    pimpl_->publish(record);
+}
+
+uint64_t ExportChannel::published() const {
+    return pimpl_->published();
+}
+
+} // namespace response
+} // namespace nips
@@ -0,0 +1,424 @@
+#include "response/response_controller.hpp"
+#include "response/export_channel.hpp"
+#include "common/config.hpp"
+#include "common/logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <arpa/inet.h>
+
+namespace nips {
+namespace response {
+
+namespace {
+
+const char* actionTypeName(ActionType type) {
+    switch (type) {
+        case ActionType::BLOCK: return "BLOCK";
+        case ActionType::RATE_LIMIT: return "RATE_LIMIT";
+        case ActionType::LOG: return "LOG";
+        case ActionType::ALERT: return "ALERT";
+        case ActionType::REDIRECT: return "REDIRECT";
+        case ActionType::CUSTOM: return "CUSTOM";
+    }
+    return "UNKNOWN";
+}
+
+// 动作去重键：同一目标上的同类动作只执行一次
+std::string dedupKey(const ResponseAction& action) {
+    return std::string(actionTypeName(action.type)) + ":" + action.target;
+}
+
+bool isValidIpTarget(const std::string& target) {
+    struct in_addr addr;
+    return inet_pton(AF_INET, target.c_str(), &addr) == 1;
+}
+
+} // namespace
+
+// 异步响应执行器：executeAction只做入队（有界MPSC队列 + 去重），
+// 防火墙调用在专用响应线程上执行。攻击洪峰下成千上万个相同
+// 威胁只产生一次iptables调用，检测路径永不阻塞在shell-out上
+class ResponseController::Impl {
+public:
+    ~Impl() { stopResponder(); }
+
+    bool init(const std::string& config_path) {
+        auto& config = common::Config::getInstance();
+        if (!config.load(config_path)) {
+            return false;
+        }
+        auto cfg = config.snapshot();
+
+        policy_path_ = cfg->response.policy_path;
+        enable_auto_response_ = cfg->response.enable_auto_response;
+        max_queue_ = cfg->response.max_concurrent_actions;
+        log_path_ = cfg->response.log_path;
+
+        log_.open(log_path_, std::ios::app);
+        if (!log_.is_open()) {
+            NIPS_WARN("无法打开响应日志 {}", log_path_);
+        }
+
+        // 共享内存导出通道：后端的机器读取路径；不可用时
+        // 回退到JSON文本日志（logResponse），只降级不失败
+        if (!cfg->response.export_shm.empty()) {
+            auto channel = std::make_unique<ExportChannel>();
+            if (channel->init(cfg->response.export_shm,
+                              cfg->response.export_capacity)) {
+                channel_ = std::move(channel);
+            } else {
+                NIPS_WARN("共享内存导出通道不可用，回退JSON文本日志");
+            }
+        }
+
+        startResponder();
+        return true;
+    }
+
+    // 威胁记录发布（检测线程上下文；通道内部无锁多生产者）
+    void publishThreat(const detection::ThreatInfo& threat) {
+        if (channel_) {
+            channel_->publishThreat(threat);
+        }
+    }
+
+    uint64_t exportedRecords() const {
+        return channel_ ? channel_->published() : 0;
+    }
+
+    // 入队一个响应动作；队列满或短期内重复的动作被丢弃
+    bool enqueue(const ResponseAction& action) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto key = dedupKey(action);
+            const auto now = std::chrono::steady_clock::now();
+            auto it = recent_.find(key);
+            if (it != recent_.end() && now < it->second) {
+                deduped_++;
+                return true;  // 同目标动作仍在生效期内，抑制重复
+            }
+            recent_[key] = now + std::chrono::seconds(
+                action.duration.count() > 0 ? action.duration.count() : 60);
+
+            // 周期性清扫过期的去重键：不清扫的话每个出现过的目标
+            // 都会常驻内存，伪造源IP的洪水可以把映射撑到无界
+            if (++inserts_since_sweep_ >= kSweepInterval) {
+                inserts_since_sweep_ = 0;
+                for (auto it2 = recent_.begin(); it2 != recent_.end();) {
+                    it2 = now >= it2->second ? recent_.erase(it2) : std::next(it2);
+                }
+            }
+
+            if (queue_.size() >= max_queue_) {
+                NIPS_WARN("响应队列已满({}), 丢弃动作 {} {}",
+                          max_queue_, actionTypeName(action.type), action.target);
+                return false;
+            }
+            queue_.push_back(action);
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    // 同步执行一个动作（响应线程上下文）
+    bool execute(const ResponseAction& action) {
+        bool success = false;
+        switch (action.type) {
+            case ActionType::BLOCK:
+                success = applyBlock(action.target);
+                break;
+            case ActionType::RATE_LIMIT:
+                success = applyRateLimit(action.target, 100);
+                break;
+            case ActionType::LOG:
+                success = true;
+                break;
+            case ActionType::ALERT:
+                sendAlert(action);
+                success = true;
+                break;
+            default:
+                NIPS_WARN("未实现的动作类型: {}", actionTypeName(action.type));
+                break;
+        }
+
+        if (success) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_.push_back(action);
+        }
+        if (channel_) {
+            channel_->publishAction(action, success);
+        }
+        logResponse(action, success);
+
+        if (callback_) {
+            callback_(action);
+        }
+        return success;
+    }
+
+    bool applyBlock(const std::string& target) {
+        if (!isValidIpTarget(target)) {
+            NIPS_WARN("拒绝阻断非法目标: {}", target);
+            return false;
+        }
+        std::string cmd = "iptables -I INPUT -s " + target + " -j DROP";
+        const int result = std::system(cmd.c_str());
+        if (result != 0) {
+            NIPS_ERROR("阻断 {} 失败 (exit={})", target, result);
+            return false;
+        }
+        NIPS_WARN("已阻断 {}", target);
+        return true;
+    }
+
+    bool applyRateLimit(const std::string& target, uint32_t rate) {
+        if (!isValidIpTarget(target)) {
+            NIPS_WARN("拒绝限速非法目标: {}", target);
+            return false;
+        }
+        std::string cmd = "iptables -I INPUT -s " + target +
+            " -m hashlimit --hashlimit-above " + std::to_string(rate) +
+            "/sec --hashlimit-name nips_" + target + " -j DROP";
+        const int result = std::system(cmd.c_str());
+        if (result != 0) {
+            NIPS_ERROR("限速 {} 失败 (exit={})", target, result);
+            return false;
+        }
+        NIPS_WARN("已限速 {} 至 {}/s", target, rate);
+        return true;
+    }
+
+    bool revoke(const std::string& target) {
+        std::string cmd = "iptables -D INPUT -s " + target + " -j DROP";
+        if (!isValidIpTarget(target) || std::system(cmd.c_str()) != 0) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = active_.begin(); it != active_.end(); ++it) {
+            if (it->target == target) {
+                active_.erase(it);
+                break;
+            }
+        }
+        // 去重键全部清掉：撤销后同目标的限速/告警也应立即可再触发
+        recent_.erase(std::string("BLOCK:") + target);
+        recent_.erase(std::string("RATE_LIMIT:") + target);
+        recent_.erase(std::string("ALERT:") + target);
+        return true;
+    }
+
+    void sendAlert(const ResponseAction& action) {
+        NIPS_WARN("威胁告警: {} (原因: {})", action.target, action.reason);
+    }
+
+    void logResponse(const ResponseAction& action, bool success) {
+        // 机器路径走共享内存后不再逐条写文本：人读的WARN日志
+        // （阻断/告警）已由各执行函数输出，告警风暴下省掉
+        // 格式化+flush；通道禁用时保持旧行为供后端tail
+        if (channel_ || !log_.is_open()) {
+            return;
+        }
+        const auto now = std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now());
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        log_ << "{\"time\":" << now
+             << ",\"action\":\"" << actionTypeName(action.type)
+             << "\",\"target\":\"" << action.target
+             << "\",\"reason\":\"" << action.reason
+             << "\",\"success\":" << (success ? "true" : "false") << "}\n";
+        log_.flush();
+    }
+
+    std::vector<ResponseAction> activeActions() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return active_;
+    }
+
+    std::string policy_path_;
+    bool enable_auto_response_ = true;
+    size_t max_queue_ = 100;
+    std::string log_path_;
+    ActionCallback callback_;
+
+private:
+    void startResponder() {
+        running_ = true;
+        responder_ = std::thread([this]() { responderLoop(); });
+    }
+
+    void stopResponder() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        cv_.notify_all();
+        if (responder_.joinable()) {
+            responder_.join();
+        }
+    }
+
+    // 响应线程主循环：排空动作队列
+    void responderLoop() {
+        for (;;) {
+            ResponseAction action;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+                if (!running_ && queue_.empty()) {
+                    return;
+                }
+                action = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            try {
+                execute(action);
+            } catch (const std::exception& e) {
+                NIPS_ERROR("执行响应动作失败: {}", e.what());
+            }
+        }
+    }
+
+    std::deque<ResponseAction> queue_;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> recent_;
+    std::vector<ResponseAction> active_;
+    uint64_t deduped_ = 0;
+    static constexpr size_t kSweepInterval = 64;  // 每N次插入清扫一次过期去重键
+    size_t inserts_since_sweep_ = 0;
+    std::unique_ptr<ExportChannel> channel_;
+    std::mutex mutex_;
+    std::mutex log_mutex_;
+    std::condition_variable cv_;
+    std::thread responder_;
+    bool running_ = false;
+    std::ofstream log_;
+};
+
+ResponseController::ResponseController() : pimpl_(std::make_unique<Impl>()) {}
+
+ResponseController::~ResponseController() = default;
+
+bool ResponseController::init(const std::string& config_path) {
+    if (!pimpl_->init(config_path)) {
+        NIPS_ERROR("无法初始化响应控制器");
+        return false;
+    }
+    NIPS_INFO("响应控制器已初始化 (自动响应: {}, 队列上限: {})",
+              pimpl_->enable_auto_response_, pimpl_->max_queue_);
+    return true;
+}
+
+ResponseAction ResponseController::handleThreat(const detection::ThreatInfo& threat) {
+    // 威胁本身先进导出通道：动作被去重抑制时后端也能看到威胁
+    pimpl_->publishThreat(threat);
+    return generateAction(threat);
+}
+
+uint64_t ResponseController::exportedRecords() const {
+    return pimpl_->exportedRecords();
+}
+
+bool ResponseController::executeAction(const ResponseAction& action) {
+    if (!validateAction(action)) {
+        return false;
+    }
+    // 异步：仅入队，由响应线程执行
+    return pimpl_->enqueue(action);
+}
+
+bool ResponseController::revokeAction(const std::string& action_id) {
+    return pimpl_->revoke(action_id);
+}
+
+void ResponseController::setActionCallback(ActionCallback callback) {
+    pimpl_->callback_ = std::move(callback);
+}
+
+std::vector<ResponseAction> ResponseController::getActiveActions() {
+    return pimpl_->activeActions();
+}
+
+bool ResponseController::updateResponsePolicy(const std::string& policy_path) {
+    pimpl_->policy_path_ = policy_path;
+    return true;
+}
+
+bool ResponseController::exportResponseLog(const std::string& file_path) {
+    std::ifstream src(pimpl_->log_path_, std::ios::binary);
+    std::ofstream dst(file_path, std::ios::binary);
+    if (!src.is_open() || !dst.is_open()) {
+        return false;
+    }
+    dst << src.rdbuf();
+    return true;
+}
+
+ResponseAction ResponseController::generateAction(const detection::ThreatInfo& threat) {
+    ResponseAction action;
+    action.target = threat.source_ip;
+    action.reason = threat.description.empty() ? threat.type : threat.description;
+
+    if (!pimpl_->enable_auto_response_) {
+        action.type = ActionType::LOG;
+        action.duration = std::chrono::seconds(0);
+        return action;
+    }
+
+    switch (threat.level) {
+        case detection::ThreatLevel::CRITICAL:
+            action.type = ActionType::BLOCK;
+            action.duration = std::chrono::seconds(3600);
+            break;
+        case detection::ThreatLevel::HIGH:
+            action.type = ActionType::BLOCK;
+            action.duration = std::chrono::seconds(600);
+            break;
+        case detection::ThreatLevel::MEDIUM:
+            action.type = ActionType::RATE_LIMIT;
+            action.duration = std::chrono::seconds(300);
+            break;
+        case detection::ThreatLevel::LOW:
+            action.type = ActionType::ALERT;
+            action.duration = std::chrono::seconds(60);
+            break;
+        default:
+            action.type = ActionType::LOG;
+            action.duration = std::chrono::seconds(0);
+            break;
+    }
+    return action;
+}
+
+bool ResponseController::validateAction(const ResponseAction& action) {
+    if (action.type == ActionType::BLOCK || action.type == ActionType::RATE_LIMIT) {
+        return !action.target.empty();
+    }
+    return true;
+}
+
+bool ResponseController::applyRateLimit(const std::string& target, uint32_t rate) {
+    return pimpl_->applyRateLimit(target, rate);
+}
+
+bool ResponseController::applyBlock(const std::string& target) {
+    return pimpl_->applyBlock(target);
+}
+
+void ResponseController::sendAlert(const ResponseAction& action) {
+    pimpl_->sendAlert(action);
+}
+
+void ResponseController::logResponse(const ResponseAction& action, bool success) {
+    pimpl_->logResponse(action, success);
+}
+
+} // namespace response
+} // namespace nips
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""NIPS二进制流记录读取器
+
+解析C++端FlowRecordWriter导出的段文件（include/feature/flow_record_writer.hpp）：
+32字节段头 + 定长224字节记录（5元组 + 导出时间 + 采样率 + 50维特征向量）。
+只读取段头record_count以内的记录，崩溃残留的尾部数据自动忽略。
+v2记录带sample_rate：<1时计数类特征需除以它回算原始量级。
+v3启用原pad字节存ip_version（布局与v2相同）：6表示IPv6，
+此时src_ip/dst_ip是128位地址的32位折叠，仅可作流标识。
+"""
+
+import glob
+import os
+import struct
+
+import numpy as np
+
+MAGIC = b'NIPSFLOW'
+FORMAT_VERSION = 3
+
+HEADER_STRUCT = struct.Struct('<8sIIQQ')         # magic, version, record_size, record_count, reserved
+RECORD_STRUCT = struct.Struct('<IIHHBB2xIf50f')  # src_ip, dst_ip, src_port, dst_port, proto, ip_version, pad, export_time, sample_rate, features
+FEATURE_DIM = 50
+
+
+def read_segment(path):
+    """读取单个段文件，返回 (meta, features)
+
+    meta: structured numpy数组（src_ip/dst_ip/src_port/dst_port/protocol/
+          ip_version/export_time/sample_rate）
+    features: (N, 50) float32数组
+    """
+    meta_dtype = np.dtype([
+        ('src_ip', '<u4'), ('dst_ip', '<u4'),
+        ('src_port', '<u2'), ('dst_port', '<u2'),
+        ('protocol', 'u1'), ('ip_version', 'u1'),
+        ('export_time', '<u4'), ('sample_rate', '<f4'),
+    ])
+
+    with open(path, 'rb') as f:
+        header = f.read(HEADER_STRUCT.size)
+        if len(header) < HEADER_STRUCT.size:
+            raise ValueError(f'{path}: 段文件头不完整')
+        magic, version, record_size, record_count, _ = HEADER_STRUCT.unpack(header)
+        if magic != MAGIC:
+            raise ValueError(f'{path}: 非NIPS流记录文件')
+        if version != FORMAT_VERSION:
+            raise ValueError(f'{path}: 不支持的格式版本 {version}')
+        if record_size != RECORD_STRUCT.size:
+            raise ValueError(f'{path}: 记录大小不匹配 '
+                             f'({record_size} != {RECORD_STRUCT.size})')
+
+        meta = np.zeros(record_count, dtype=meta_dtype)
+        features = np.zeros((record_count, FEATURE_DIM), dtype=np.float32)
+        for i in range(record_count):
+            raw = f.read(record_size)
+            if len(raw) < record_size:
+                # 头部计数超出实际落盘数据：截断
+                meta = meta[:i]
+                features = features[:i]
+                break
+            fields = RECORD_STRUCT.unpack(raw)
+            meta[i] = tuple(fields[:8])
+            features[i] = fields[8:]
+
+    return meta, features
+
+
+def read_flow_records(export_dir):
+    """读取目录下全部段文件，按文件名排序拼接"""
+    paths = sorted(glob.glob(os.path.join(export_dir, 'flows_*.bin')))
+    if not paths:
+        return (np.zeros(0), np.zeros((0, FEATURE_DIM), dtype=np.float32))
+
+    metas = []
+    feature_arrays = []
+    for path in paths:
+        meta, features = read_segment(path)
+        metas.append(meta)
+        feature_arrays.append(features)
+
+    return np.concatenate(metas), np.concatenate(feature_arrays)
+
+
+if __name__ == '__main__':
+    import sys
+    if len(sys.argv) != 2:
+        print(f'用法: {sys.argv[0]} <export_dir>')
+        sys.exit(1)
+    meta, features = read_flow_records(sys.argv[1])
+    print(f'共 {len(meta)} 条流记录, 特征维度 {features.shape[1] if len(meta) else 0}')
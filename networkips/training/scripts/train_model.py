@@ -81,6 +81,31 @@ class AnomalyDetector(nn.Module):
         anomaly_score = self.anomaly_head(encoded)
         return decoded, anomaly_score
 
+class InferenceWrapper(nn.Module):
+    """推理专用包装：只输出异常分数，供C++端按TorchScript加载"""
+    def __init__(self, model):
+        super(InferenceWrapper, self).__init__()
+        self.model = model
+
+    def forward(self, x):
+        _, anomaly_score = self.model(x)
+        return anomaly_score
+
+def export_quantized_torchscript(model, input_dim, export_path):
+    """导出动态量化的int8 TorchScript模型（ml.model_type: torchscript_int8）
+
+    Linear层权重量化为int8，推理时动态量化激活。
+    无GPU的边缘传感器上单批推理可快3-4倍，模型内存约为fp32的1/4。
+    """
+    wrapper = InferenceWrapper(model.to('cpu').eval()).eval()
+    quantized = torch.quantization.quantize_dynamic(
+        wrapper, {nn.Linear}, dtype=torch.qint8
+    )
+    example = torch.zeros(1, input_dim)
+    scripted = torch.jit.trace(quantized, example)
+    scripted.save(export_path)
+    logging.info(f'量化TorchScript模型已导出到: {export_path}')
+
 def load_data(data_dir):
     """加载训练数据"""
     features = []
@@ -218,6 +243,12 @@ def main():
         device, num_epochs, model_save_path
     )
     
+    # 用最佳checkpoint导出int8 TorchScript推理模型
+    checkpoint = torch.load(model_save_path, map_location='cpu')
+    model.load_state_dict(checkpoint['model_state_dict'])
+    int8_path = os.path.join(model_save_dir, 'anomaly_detector_int8.pt')
+    export_quantized_torchscript(model, input_dim, int8_path)
+
     # 保存训练历史
     history = {
         'train_losses': train_losses,